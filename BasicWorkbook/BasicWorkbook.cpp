@@ -19,37 +19,26 @@
 #include <stdexcept>
 #include <cctype>
 #include <limits>
+#include <cmath>
+#include <cstring>
+#include <charconv>
 #include <chrono>
 #include <ctime>
 #include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <numeric>
 #include "BasicWorkbook.h"
 
 namespace BasicWorkbook
 {
   /**
    * The sorting criterion here makes storing all the Sheet's
-   * cells in a set practical. It sorts first by row, and then
-   * within row by column.
-   *
-   * Since sets are always kept in sorted order, and Sheets
-   * must be written in order of row, one only need to iterate
-   * the set to get the cells in the desired order.
-   */
-  bool cell_sort_compare::operator() (const cell_t &a, const cell_t &b) const noexcept
-  {
-    if (a.integerref.row < b.integerref.row ||
-        (a.integerref.row == b.integerref.row && 
-         a.integerref.col < b.integerref.col))
-    {
-      return true;
-    }
-
-    return false;
-  }
-
-  /**
-   * Similar behavior to cell_sort_compare::operator() above, but
-   * it operates on the start_ref of a merged_cell_t.
+   * merged cells in a set practical. It sorts first by the row
+   * of start_ref, and then within row by column.
    */
   bool merged_cell_sort_compare::operator() (const merged_cell_t &a, const merged_cell_t &b) const noexcept
   {
@@ -135,6 +124,57 @@ namespace BasicWorkbook
     return integer;
   }
 
+  /**
+   * The alphabetic index of every column, so that cell references
+   * need no per-cell column arithmetic. Column col's index is the
+   * first lengths[col] characters of names[col]; entry 0 is unused.
+   */
+  typedef struct
+  {
+    char names[MAX_COL + 1u][3];
+    uint8_t lengths[MAX_COL + 1u];
+  } column_names_t;
+
+  /**
+   * Fills a column_names_t using the same base 26 scheme that
+   * column_to_integer() reverses.
+   */
+  static column_names_t build_column_names(void) noexcept
+  {
+    column_names_t output = {};
+    for (uint32_t jCol = 1u; jCol <= MAX_COL; jCol++)
+    {
+      char reversed[3];
+      uint8_t length = 0u;
+      uint32_t integer = jCol;
+
+      while (integer > 0u)
+      {
+        uint32_t remainder = integer % 26u;
+        integer--;
+        integer /= 26u;
+        reversed[length++] = (remainder == 0u ? 'Z' : static_cast<char>(remainder + 64u));
+      }
+
+      for (uint8_t jChar = 0u; jChar < length; jChar++)
+      {
+        output.names[jCol][jChar] = reversed[length - 1u - jChar];
+      }
+      output.lengths[jCol] = length;
+    }
+    return output;
+  }
+
+  /**
+   * The column name table, built on first use. Function local
+   * static initialization is thread safe.
+   */
+  static const column_names_t& column_names(void) noexcept
+  {
+    static const column_names_t names = build_column_names();
+    return names;
+  }
+
   /**
    * Convert a column index expressed as an integer (>= 1) to
    * the equivalent alphabetic index, where A = 1, B = 2,
@@ -152,25 +192,8 @@ namespace BasicWorkbook
       throw std::invalid_argument(std::string("integer_to_column() received a too large column index."));
     }
     
-    std::string column;
-
-    while (integer > 0u)
-    {
-      uint32_t remainder = integer % 26u;
-      integer--;
-      integer /= 26u;
-
-      if (remainder == 0u)
-      {
-        column.insert(0u, 1u, 'Z');
-      }
-      else
-      {
-        column.insert(0u, 1u, static_cast<char>(remainder + 64u));
-      }
-    }
-
-    return column;
+    const column_names_t &table = column_names();
+    return std::string(table.names[integer], table.lengths[integer]);
   }
 
   /**
@@ -283,7 +306,32 @@ namespace BasicWorkbook
       throw std::invalid_argument(std::string("integerref_to_mixedref() received an invalid cell reference."));
     }
 
-    return integer_to_column(integerref.col) + std::to_string(integerref.row);
+    char mixedref[MAX_MIXEDREF_LEN];
+    size_t length = write_mixedref(mixedref, integerref.row, integerref.col);
+    return std::string(mixedref, length);
+  }
+
+  /**
+   * Writes the mixedref format cell reference of row and col to
+   * output without allocating memory and returns its length.
+   * output must have room for MAX_MIXEDREF_LEN characters; no
+   * terminating '\0' is written.
+   */
+  size_t write_mixedref(char *output, const uint32_t row, const uint32_t col) noexcept(false)
+  {
+    if (col < 1u || 
+        col > MAX_COL ||
+        row < 1u ||
+        row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string("write_mixedref() received an invalid cell reference."));
+    }
+
+    const column_names_t &table = column_names();
+    const size_t col_length = table.lengths[col];
+    std::copy(table.names[col], table.names[col] + col_length, output);
+    std::to_chars_result result = std::to_chars(output + col_length, output + MAX_MIXEDREF_LEN, row);
+    return static_cast<size_t>(result.ptr - output);
   }
 
   /**
@@ -309,356 +357,755 @@ namespace BasicWorkbook
   }
 
   /**
-   * Add a cell with a numeric value to this Sheet at the specified row & column.
-   * integerref_t is a little inconvenient for the caller, so this interface is
-   * provided to make things easier.
+   * OutputBuffer basic constructor; the buffer starts out empty
+   * with no storage, which will come from memory_.
    */
-  void Sheet::add_number_cell(const uint32_t row, const uint32_t col, const double number, const cell_style_t &cell_style) noexcept(false)
+  OutputBuffer::OutputBuffer(std::pmr::memory_resource *memory_) noexcept : memory(memory_), storage(nullptr), length(0u), allocated(0u)
   {
-    integerref_t integerref;
-    integerref.row = row;
-    integerref.col = col;
-    this->add_number_cell(integerref, number, cell_style);
+    /* Nothing. */
   }
 
   /**
-   * Add a cell with a numeric value to this Sheet at the specified row & column.
+   * OutputBuffer move constructor; other is left empty with no
+   * storage.
    */
-  void Sheet::add_number_cell(const integerref_t &integerref, const double number, const cell_style_t &cell_style) noexcept(false)
+  OutputBuffer::OutputBuffer(OutputBuffer &&other) noexcept : memory(other.memory), storage(other.storage), length(other.length), allocated(other.allocated)
   {
-    if (integerref.col < 1u || 
-        integerref.col > MAX_COL ||
-        integerref.row < 1u ||
-        integerref.row > MAX_ROW)
-    {
-      throw std::invalid_argument(std::string("add_number_cell() received an invalid cell reference."));
-    }
-
-    cell_t cell = {0};
-    cell.integerref = integerref;
-    cell.type = CellType::NUMBER;
-    cell.style_index = workbook.addStyle(cell_style);
-    cell.num_val = number;
-    
-    std::pair<std::set<cell_t,cell_sort_compare>::iterator, bool> insret = cells.insert(std::move(cell));
-    if (!insret.second)
-    {
-      throw std::runtime_error(std::string("add_number_cell() encountered duplicate insertion of a cell at the same reference."));
-    }
-    used_columns.insert(integerref.col);
+    other.storage = nullptr;
+    other.length = 0u;
+    other.allocated = 0u;
   }
 
   /**
-   * Add a cell with a numeric value to this Sheet at the specified row & column.
-   * The caller may prefer to use mixedref format, especially if they are working
-   * with formulas. This interface is provided to support that.
+   * OutputBuffer move assignment; other is left empty with no
+   * storage.
    */
-  void Sheet::add_number_cell(const std::string &mixedref, const double number, const cell_style_t &cell_style) noexcept(false)
+  OutputBuffer& OutputBuffer::operator=(OutputBuffer &&other) noexcept
   {
-    integerref_t integerref = mixedref_to_integerref(mixedref);
-    this->add_number_cell(integerref, number, cell_style);
+    if (this != &other)
+    {
+      release();
+      memory = other.memory;
+      storage = other.storage;
+      length = other.length;
+      allocated = other.allocated;
+      other.storage = nullptr;
+      other.length = 0u;
+      other.allocated = 0u;
+    }
+    return *this;
   }
 
   /**
-   * Merge the cells bounded by start_ref (upper left corner) and end_ref
-   * (lower right corner) and put the supplied numeric value in this merged cell.
-   * integerref_t is a little inconvenient for the caller, so this interface is
-   * provided to make things easier.
+   * OutputBuffer destructor; gives the storage back to the
+   * memory resource.
    */
-  void Sheet::add_merged_number_cell(const uint32_t start_row, const uint32_t start_col, const uint32_t end_row, const uint32_t end_col, const double number, const cell_style_t &cell_style) noexcept(false)
+  OutputBuffer::~OutputBuffer(void) noexcept
   {
-    integerref_t start_ref;
-    start_ref.row = start_row;
-    start_ref.col = start_col;
-
-    integerref_t end_ref;
-    end_ref.row = end_row;
-    end_ref.col = end_col;
-
-    this->add_merged_number_cell(start_ref, end_ref, number, cell_style);
+    release();
   }
 
   /**
-   * Merge the cells bounded by start_ref (upper left corner) and end_ref
-   * (lower right corner) and put the supplied numeric value in this merged cell.
+   * Makes room for at least new_capacity characters in total,
+   * keeping the current contents.
    */
-  void Sheet::add_merged_number_cell(const integerref_t &start_ref, const integerref_t &end_ref, const double number, const cell_style_t &cell_style) noexcept(false)
+  void OutputBuffer::reserve(const size_t new_capacity) noexcept(false)
   {
-    if (start_ref.col < 1u || 
-        start_ref.col > MAX_COL ||
-        start_ref.row < 1u ||
-        start_ref.row > MAX_ROW)
+    if (new_capacity <= allocated)
     {
-      throw std::invalid_argument(std::string("add_merged_number_cell() received an invalid starting cell reference."));
+      return;
     }
 
-    if (end_ref.col < 1u || 
-        end_ref.col > MAX_COL ||
-        end_ref.row < 1u ||
-        end_ref.row > MAX_ROW)
+    char *new_storage = static_cast<char*>(memory->allocate(new_capacity, 1u));
+    if (length > 0u)
     {
-      throw std::invalid_argument(std::string("add_merged_number_cell() received an invalid ending cell reference."));
+      std::memcpy(new_storage, storage, length);
     }
-
-    if (start_ref.col > end_ref.col || 
-        start_ref.row > end_ref.row ||
-        (start_ref.col == end_ref.col &&
-         start_ref.row == end_ref.row))
+    if (storage != nullptr)
     {
-      throw std::invalid_argument(std::string("add_merged_number_cell() received an ending cell reference equal or prior to its starting cell reference."));
+      memory->deallocate(storage, allocated, 1u);
     }
+    storage = new_storage;
+    allocated = new_capacity;
+  }
 
-    this->add_number_cell(start_ref, number, cell_style);
-
-    for (uint32_t jRow = start_ref.row; jRow <= end_ref.row; jRow++)
+  /**
+   * Returns the position at which the next character goes, with
+   * room for at least count characters from there on. Growing
+   * the buffer at least doubles its capacity, so appends take
+   * amortized constant time.
+   */
+  char* OutputBuffer::make_room(const size_t count) noexcept(false)
+  {
+    if (allocated - length < count)
     {
-      for (uint32_t jCol = start_ref.col; jCol <= end_ref.col; jCol++)
-      {
-        if (jRow == start_ref.row && jCol == start_ref.col)
-        {
-          continue;
-        }
-
-        integerref_t this_ref;
-        this_ref.row = jRow;
-        this_ref.col = jCol;
-        this->add_empty_cell(this_ref, cell_style);
-      }
+      reserve(std::max(2u * allocated, length + count));
     }
-
-    merged_cell_t this_merge;
-    this_merge.start_ref = start_ref;
-    this_merge.end_ref = end_ref;
-    merged_cells.insert(std::move(this_merge));
+    return storage + length;
   }
 
   /**
-   * Merge the cells bounded by start_ref (upper left corner) and end_ref
-   * (lower right corner) and put the supplied numeric value in this merged cell.
-   * The caller may prefer to use mixedref format, especially if they are working
-   * with formulas. This interface is provided to support that.
+   * Adds the characters written since the last make_room() call,
+   * up to but not including end, to the contents.
    */
-  void Sheet::add_merged_number_cell(const std::string &start_ref, const std::string &end_ref, const double number, const cell_style_t &cell_style) noexcept(false)
+  void OutputBuffer::commit(char *end) noexcept
   {
-    integerref_t int_start_ref = mixedref_to_integerref(start_ref);
-    integerref_t int_end_ref = mixedref_to_integerref(end_ref);
+    length = static_cast<size_t>(end - storage);
+  }
 
-    this->add_merged_number_cell(int_start_ref, int_end_ref, number, cell_style);
+  /**
+   * Appends length characters starting at text.
+   */
+  void OutputBuffer::append(const char *text, const size_t length_) noexcept(false)
+  {
+    char *out = make_room(length_);
+    std::memcpy(out, text, length_);
+    length += length_;
   }
 
   /**
-   * Add a cell with a formula to this Sheet at the specified row & column.
-   * integerref_t is a little inconvenient for the caller, so this interface is
-   * provided to make things easier.
+   * Appends the null terminated string text.
    */
-  void Sheet::add_formula_cell(const uint32_t row, const uint32_t col, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  void OutputBuffer::append(const char *text) noexcept(false)
   {
-    integerref_t integerref;
-    integerref.row = row;
-    integerref.col = col;
-    this->add_formula_cell(integerref, formula, cell_style);
+    this->append(text, std::strlen(text));
   }
 
   /**
-   * Add a cell with a formula to this Sheet at the specified row & column.
+   * Appends the contents of text.
    */
-  void Sheet::add_formula_cell(const integerref_t &integerref, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  void OutputBuffer::append(const std::string_view text) noexcept(false)
   {
-    if (integerref.col < 1u || 
-        integerref.col > MAX_COL ||
-        integerref.row < 1u ||
-        integerref.row > MAX_ROW)
-    {
-      throw std::invalid_argument(std::string("add_formula_cell() received an invalid cell reference."));
-    }
+    this->append(text.data(), text.size());
+  }
 
-    if (formula.length() > MAX_FORMULA_LEN)
-    {
-      throw std::invalid_argument(std::string("the formula supplied to add_formula_cell() is too long."));
-    }
+  /**
+   * Drops every character past the first new_length.
+   */
+  void OutputBuffer::truncate(const size_t new_length) noexcept
+  {
+    length = std::min(length, new_length);
+  }
 
-    cell_t cell = {0};
-    cell.integerref = integerref;
-    cell.type = CellType::FORMULA;
-    cell.style_index = workbook.addStyle(cell_style);
-    cell.str_fml_val = formula;
-    cell.num_val = std::numeric_limits<double>::quiet_NaN();
+  /**
+   * Empties the buffer but keeps its capacity.
+   */
+  void OutputBuffer::clear(void) noexcept
+  {
+    length = 0u;
+  }
 
-    std::pair<std::set<cell_t,cell_sort_compare>::iterator, bool> insret = cells.insert(std::move(cell));
-    if (!insret.second)
+  /**
+   * Empties the buffer and gives its storage back to the memory
+   * resource.
+   */
+  void OutputBuffer::release(void) noexcept
+  {
+    if (storage != nullptr)
     {
-      throw std::runtime_error(std::string("add_formula_cell() encountered duplicate insertion of a cell at the same reference."));
+      memory->deallocate(storage, allocated, 1u);
     }
-    used_columns.insert(integerref.col);
+    storage = nullptr;
+    length = 0u;
+    allocated = 0u;
   }
 
   /**
-   * Add a cell with a formula to this Sheet at the specified row & column.
-   * The caller may prefer to use mixedref format, especially if they are working
-   * with formulas. This interface is provided to support that.
+   * The contents of the buffer, which are not null terminated.
    */
-  void Sheet::add_formula_cell(const std::string &mixedref, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  const char* OutputBuffer::data(void) const noexcept
   {
-    integerref_t integerref = mixedref_to_integerref(mixedref);
-    this->add_formula_cell(integerref, formula, cell_style);
+    return storage;
   }
 
   /**
-   * Merge the cells bounded by start_ref (upper left corner) and end_ref
-   * (lower right corner) and put the supplied formula in this merged cell.
-   * integerref_t is a little inconvenient for the caller, so this interface is
-   * provided to make things easier.
+   * The number of characters in the buffer.
    */
-  void Sheet::add_merged_formula_cell(const uint32_t start_row, const uint32_t start_col, const uint32_t end_row, const uint32_t end_col, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  size_t OutputBuffer::size(void) const noexcept
   {
-    integerref_t start_ref;
-    start_ref.row = start_row;
-    start_ref.col = start_col;
+    return length;
+  }
 
-    integerref_t end_ref;
-    end_ref.row = end_row;
-    end_ref.col = end_col;
+  /**
+   * The number of characters the buffer can hold before it has to
+   * grow.
+   */
+  size_t OutputBuffer::capacity(void) const noexcept
+  {
+    return allocated;
+  }
 
-    this->add_merged_formula_cell(start_ref, end_ref, formula, cell_style);
+  /**
+   * TextArena basic constructor; the arena starts out with no
+   * chunks, which will come from memory_.
+   */
+  TextArena::TextArena(std::pmr::memory_resource *memory_) noexcept : memory(memory_), chunks(memory_), current_chunk(0u), chunk_used(0u)
+  {
+    /* Nothing. */
   }
 
   /**
-   * Merge the cells bounded by start_ref (upper left corner) and end_ref
-   * (lower right corner) and put the supplied formula in this merged cell.
+   * TextArena destructor; gives every chunk back to the memory
+   * resource.
    */
-  void Sheet::add_merged_formula_cell(const integerref_t &start_ref, const integerref_t &end_ref, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  TextArena::~TextArena(void) noexcept
   {
-    if (start_ref.col < 1u || 
-        start_ref.col > MAX_COL ||
-        start_ref.row < 1u ||
-        start_ref.row > MAX_ROW)
+    for (size_t jChunk = 0u; jChunk < chunks.size(); jChunk++)
     {
-      throw std::invalid_argument(std::string("add_merged_formula_cell() received an invalid starting cell reference."));
+      memory->deallocate(chunks[jChunk].first, chunks[jChunk].second, 1u);
     }
+  }
 
-    if (end_ref.col < 1u || 
-        end_ref.col > MAX_COL ||
-        end_ref.row < 1u ||
-        end_ref.row > MAX_ROW)
+  /**
+   * Copies text into the arena and returns a view of the copy,
+   * which stays valid until clear().
+   */
+  std::string_view TextArena::store(const std::string_view text) noexcept(false)
+  {
+    if (chunks.empty() || chunks[current_chunk].second - chunk_used < text.size())
     {
-      throw std::invalid_argument(std::string("add_merged_formula_cell() received an invalid ending cell reference."));
+      /* Move on to the next chunk kept from before clear(), or to a new one. */
+      const size_t next_chunk = (chunks.empty() ? 0u : current_chunk + 1u);
+      if (next_chunk >= chunks.size() || chunks[next_chunk].second < text.size())
+      {
+        const size_t new_size = std::max(TEXT_ARENA_CHUNK, text.size());
+        chunks.reserve(chunks.size() + 1u);
+        chunks.emplace(chunks.begin() + next_chunk, static_cast<char*>(memory->allocate(new_size, 1u)), new_size);
+      }
+      current_chunk = next_chunk;
+      chunk_used = 0u;
     }
 
-    if (start_ref.col > end_ref.col || 
-        start_ref.row > end_ref.row ||
-        (start_ref.col == end_ref.col &&
-         start_ref.row == end_ref.row))
+    char *copy = chunks[current_chunk].first + chunk_used;
+    std::memcpy(copy, text.data(), text.size());
+    chunk_used += text.size();
+    return std::string_view(copy, text.size());
+  }
+
+  /**
+   * Drops every string stored in the arena, keeping the chunks
+   * for the strings stored next.
+   */
+  void TextArena::clear(void) noexcept
+  {
+    current_chunk = 0u;
+    chunk_used = 0u;
+  }
+
+  /**
+   * Packs every field of cell_style into one integer, so that two
+   * styles are equal exactly when their keys are:
+   * bits 0-7 num_format, 8-9 horiz_align, 10-11 vert_align,
+   * bit 12 wrap_text and bit 13 bold.
+   */
+  static uint32_t style_key(const cell_style_t &cell_style) noexcept
+  {
+    return static_cast<uint32_t>(cell_style.num_format) |
+           (static_cast<uint32_t>(cell_style.horiz_align) << 8u) |
+           (static_cast<uint32_t>(cell_style.vert_align) << 10u) |
+           (static_cast<uint32_t>(cell_style.wrap_text) << 12u) |
+           (static_cast<uint32_t>(cell_style.bold) << 13u);
+  }
+
+  /**
+   * Throws if value is too long or has too many line breaks for
+   * a string cell. caller names the public method for the
+   * exception message.
+   */
+  static void check_string_value(const std::string &value, const char *caller) noexcept(false)
+  {
+    if (value.length() > MAX_STRING_LEN)
     {
-      throw std::invalid_argument(std::string("add_merged_formula_cell() received an ending cell reference equal or prior to its starting cell reference."));
+      throw std::invalid_argument(std::string("the string value supplied to ") + caller + " is too long.");
     }
 
-    this->add_formula_cell(start_ref, formula, cell_style);
+    if (std::count(value.begin(), value.end(), '\n') > MAX_STRING_LINE_BREAKS)
+    {
+      throw std::invalid_argument(std::string("the string value supplied to ") + caller + " contains too many line breaks.");
+    }
+  }
 
-    for (uint32_t jRow = start_ref.row; jRow <= end_ref.row; jRow++)
+  /**
+   * Throws if any of the cols column pointers passed to
+   * Sheet::add_columns() is null. caller names the public method
+   * for the exception message.
+   */
+  template <typename T>
+  static void check_columns(const T *const *columns, const uint32_t cols, const char *caller) noexcept(false)
+  {
+    for (uint32_t jCol = 0u; jCol < cols; jCol++)
     {
-      for (uint32_t jCol = start_ref.col; jCol <= end_ref.col; jCol++)
+      if (columns[jCol] == nullptr)
       {
-        if (jRow == start_ref.row && jCol == start_ref.col)
-        {
-          continue;
-        }
+        throw std::invalid_argument(std::string(caller) + " received a null column pointer.");
+      }
+    }
+  }
 
-        integerref_t this_ref;
-        this_ref.row = jRow;
-        this_ref.col = jCol;
-        this->add_empty_cell(this_ref, cell_style);
+  /**
+   * Marks a string pool entry that is not in the shared strings
+   * table; see Workbook::shared_string_positions.
+   */
+  static const uint32_t NOT_SHARED = std::numeric_limits<uint32_t>::max();
+
+  /**
+   * A key that style_key() never produces, held by
+   * Workbook::last_style_key before the first style is added.
+   */
+  static const uint32_t NO_STYLE_KEY = std::numeric_limits<uint32_t>::max();
+
+  /**
+   * Returns a cell block with no cells whose arrays take their
+   * memory from memory.
+   */
+  static cell_block_t empty_block(std::pmr::memory_resource *memory) noexcept
+  {
+    return cell_block_t{0u, std::pmr::vector<uint32_t>(memory), std::pmr::vector<uint32_t>(memory), std::pmr::vector<uint32_t>(memory),
+      std::pmr::vector<uint16_t>(memory), std::pmr::vector<CellType>(memory), std::pmr::vector<cell_value_t>(memory)};
+  }
+
+  /**
+   * Room to request from OutputBuffer::make_room() before writing
+   * the markup of one row start or of one cell, not counting the
+   * text of a string or formula. The longest such markup, a
+   * numeric cell with a full reference, style and 24 character
+   * number, is 63 characters.
+   */
+  static const size_t CELL_ROOM = 64u;
+
+  /**
+   * Copies the string literal text, without its terminating null,
+   * to out and returns the position following it.
+   */
+  template <size_t N>
+  static char* put_literal(char *out, const char (&text)[N]) noexcept
+  {
+    std::memcpy(out, text, N - 1u);
+    return out + (N - 1u);
+  }
+
+  /**
+   * Returns the number of decimal digits in value.
+   */
+  static size_t decimal_digits(uint64_t value) noexcept
+  {
+    size_t digits = 1u;
+    while (value >= 10u)
+    {
+      value /= 10u;
+      digits++;
+    }
+    return digits;
+  }
+
+  /**
+   * Appends the opening of a Sheet .xml file, up to but not
+   * including the <cols> element, to file.
+   */
+  static void append_worksheet_start(OutputBuffer &file) noexcept(false)
+  {
+    file.append(u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>");
+    file.append(u8"<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\">");
+    file.append(u8"<sheetViews><sheetView workbookViewId=\"0\"/></sheetViews>");
+    file.append(u8"<sheetFormatPr defaultRowHeight=\"17\"/>");
+  }
+
+  /**
+   * Appends a <cols> element giving each column in column_widths
+   * its custom width to file, if there are any.
+   */
+  static void append_column_widths(OutputBuffer &file, const std::pmr::set<std::pair<uint32_t,double>, column_widths_sort_compare> &column_widths) noexcept(false)
+  {
+    if (!column_widths.empty())
+    {
+      file.append(u8"<cols>");
+      for (std::pmr::set<std::pair<uint32_t, double>, column_widths_sort_compare>::const_iterator col_widths_itr = column_widths.cbegin();
+           col_widths_itr != column_widths.cend();
+           col_widths_itr++)
+      {
+        std::string colnum = std::to_string(col_widths_itr->first);
+        file.append(u8"<col min=\"");
+        file.append(colnum);
+        file.append(u8"\" max=\"");
+        file.append(colnum);
+        file.append(u8"\" width=\"");
+        file.append(std::to_string(col_widths_itr->second));
+        file.append(u8"\" customWidth=\"1\"/>");
       }
+      file.append(u8"</cols>");
     }
+  }
 
-    merged_cell_t this_merge;
-    this_merge.start_ref = start_ref;
-    this_merge.end_ref = end_ref;
-    merged_cells.insert(std::move(this_merge));
+  /**
+   * Appends the opening tag of row row to file, including the
+   * row's custom height if row_heights has one.
+   */
+  static void append_row_start(OutputBuffer &file, const uint32_t row, const std::pmr::set<std::pair<uint32_t,double>, row_heights_sort_compare> &row_heights) noexcept(false)
+  {
+    char *out = file.make_room(CELL_ROOM);
+    out = put_literal(out, u8"<row r=\"");
+    out = std::to_chars(out, out + CELL_ROOM, row).ptr;
+    out = put_literal(out, u8"\"");
+
+    if (!row_heights.empty())
+    {
+      std::pair<uint32_t, double> row_heights_key = std::make_pair(row, 0.0);
+      std::pmr::set<std::pair<uint32_t, double>, row_heights_sort_compare>::const_iterator row_heights_itr = row_heights.find(row_heights_key);
+      if (row_heights_itr != row_heights.end())
+      {
+        file.commit(out);
+        file.append(u8" ht=\"");
+        file.append(std::to_string(row_heights_itr->second));
+        file.append(u8"\" customHeight=\"1\"");
+        out = file.make_room(1u);
+      }
+    }
+
+    out = put_literal(out, u8">");
+    file.commit(out);
   }
 
   /**
-   * Merge the cells bounded by start_ref (upper left corner) and end_ref
-   * (lower right corner) and put the supplied formula in this merged cell.
-   * The caller may prefer to use mixedref format, especially if they are working
-   * with formulas. This interface is provided to support that.
+   * Writes number to out in the shortest form that reads back as
+   * exactly the same double and returns the position following
+   * it. out must have room for 24 characters. Integral values
+   * below 2^53 in magnitude take a faster integer path, except
+   * negative zero, which that path would write as "0". The output
+   * does not depend on the C locale.
    */
-  void Sheet::add_merged_formula_cell(const std::string &start_ref, const std::string &end_ref, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  static char* put_number(char *out, const double number) noexcept
   {
-    integerref_t int_start_ref = mixedref_to_integerref(start_ref);
-    integerref_t int_end_ref = mixedref_to_integerref(end_ref);
+    if (std::fabs(number) < 9007199254740992.0 && number == std::trunc(number) && (number != 0.0 || !std::signbit(number)))
+    {
+      return std::to_chars(out, out + 24, static_cast<int64_t>(number)).ptr;
+    }
+    return std::to_chars(out, out + 24, number).ptr;
+  }
 
-    this->add_merged_formula_cell(int_start_ref, int_end_ref, formula, cell_style);
+  /**
+   * Writes the opening of a cell element, up to but not including
+   * the > or /> that closes its start tag, to out and returns the
+   * position following it.
+   *
+   * prev_col is the column of the previous cell in the same row,
+   * or 0 for the first cell of a row. When compact is true, the r
+   * attribute is left out of a cell that directly follows prev_col
+   * and the s attribute is left out of a cell with the default
+   * style 0, both of which the standard allows.
+   */
+  static char* put_cell_start(char *out, const uint32_t row, const uint32_t col, const uint32_t prev_col, const bool compact, const uint16_t style_index) noexcept(false)
+  {
+    out = put_literal(out, u8"<c");
+
+    if (!compact || col != prev_col + 1u)
+    {
+      out = put_literal(out, u8" r=\"");
+      out += write_mixedref(out, row, col);
+      out = put_literal(out, u8"\"");
+    }
+
+    if (!compact || style_index != 0u)
+    {
+      out = put_literal(out, u8" s=\"");
+      out = std::to_chars(out, out + 8, style_index).ptr;
+      out = put_literal(out, u8"\"");
+    }
+
+    return out;
   }
 
   /**
-   * Add a cell with a string value to this Sheet at the specified row & column.
+   * Appends the .xml of a single cell to file. num_val is used by
+   * NUMBER cells and text by FORMULA and STRING cells, whose text
+   * is written inline. See put_cell_start() for prev_col and
+   * compact.
+   */
+  static void append_cell(OutputBuffer &file, const uint32_t row, const uint32_t col, const uint32_t prev_col, const bool compact, const CellType type, const uint16_t style_index, const double num_val, const std::string_view text) noexcept(false)
+  {
+    char *out = file.make_room(CELL_ROOM + text.size());
+    out = put_cell_start(out, row, col, prev_col, compact, style_index);
+
+    if (type == CellType::NUMBER)
+    {
+      out = put_literal(out, u8"><v>");
+      out = put_number(out, num_val);
+      out = put_literal(out, u8"</v></c>");
+    }
+    else if (type == CellType::FORMULA)
+    {
+      out = put_literal(out, u8"><f>");
+      out = std::copy(text.begin(), text.end(), out);
+      out = put_literal(out, u8"</f></c>");
+    }
+    else if (type == CellType::STRING)
+    {
+      out = put_literal(out, u8" t=\"inlineStr\"><is><t>");
+      out = std::copy(text.begin(), text.end(), out);
+      out = put_literal(out, u8"</t></is></c>");
+    }
+    else
+    {
+      out = put_literal(out, u8"/>");
+    }
+
+    file.commit(out);
+  }
+
+  /**
+   * Appends the .xml of a string cell whose text is entry
+   * string_index of xl/sharedStrings.xml to file. See
+   * put_cell_start() for prev_col and compact.
+   */
+  static void append_shared_string_cell(OutputBuffer &file, const uint32_t row, const uint32_t col, const uint32_t prev_col, const bool compact, const uint16_t style_index, const uint32_t string_index) noexcept(false)
+  {
+    char *out = file.make_room(CELL_ROOM);
+    out = put_cell_start(out, row, col, prev_col, compact, style_index);
+    out = put_literal(out, u8" t=\"s\"><v>");
+    out = std::to_chars(out, out + 16, string_index).ptr;
+    out = put_literal(out, u8"</v></c>");
+    file.commit(out);
+  }
+
+  /**
+   * Appends the <mergeCells> element listing merged_cells to
+   * file, if there are any, and then closes the worksheet.
+   */
+  static void append_worksheet_end(OutputBuffer &file, const std::pmr::set<merged_cell_t, merged_cell_sort_compare> &merged_cells) noexcept(false)
+  {
+    if (!merged_cells.empty())
+    {
+      file.append(u8"<mergeCells count=\"");
+      file.append(std::to_string(merged_cells.size()));
+      file.append(u8"\">");
+      
+      for (std::pmr::set<merged_cell_t, merged_cell_sort_compare>::const_iterator merged_cell_itr = merged_cells.cbegin();
+           merged_cell_itr != merged_cells.cend();
+           merged_cell_itr++)
+      {
+        const merged_cell_t &this_merge = *merged_cell_itr;
+        std::string start_mixedref = integerref_to_mixedref(this_merge.start_ref);
+        std::string end_mixedref = integerref_to_mixedref(this_merge.end_ref);
+
+        file.append(u8"<mergeCell ref=\"");
+        file.append(start_mixedref);
+        file.append(u8":");
+        file.append(end_mixedref);
+        file.append(u8"\"/>");
+      }
+      
+      file.append(u8"</mergeCells>");
+    }
+    
+    file.append(u8"</worksheet>");
+  }
+
+  /**
+   * Calls generate(0) through generate(count - 1) on num_threads
+   * worker threads and passes each result, with its index, to
+   * consume on the calling thread. If in_order is true, results
+   * are consumed in index order; otherwise in the order they are
+   * finished. Workers stay at most 2 * num_threads items ahead of
+   * consume, which bounds the memory held by waiting results.
+   *
+   * The first exception thrown by generate or consume stops the
+   * remaining work and is rethrown once all workers have stopped.
+   */
+  static void generate_parallel(const size_t count, const size_t num_threads,
+                                const std::function<OutputBuffer(size_t)> &generate,
+                                const std::function<void(size_t, OutputBuffer&)> &consume,
+                                const bool in_order) noexcept(false)
+  {
+    std::mutex queue_mutex;
+    std::condition_variable queue_filled;
+    std::condition_variable queue_drained;
+    std::map<size_t, OutputBuffer> finished;
+    size_t next_index = 0u;
+    size_t consumed = 0u;
+    size_t stopped_threads = 0u;
+    bool stop = false;
+    std::exception_ptr failure;
+    std::vector<std::thread> workers;
+
+    auto worker = [&]()
+    {
+      try
+      {
+        while (true)
+        {
+          size_t index = 0u;
+          {
+            std::unique_lock<std::mutex> queue_lock(queue_mutex);
+            queue_drained.wait(queue_lock, [&]() { return stop || next_index >= count || next_index < consumed + 2u * num_threads; });
+            if (stop || next_index >= count)
+            {
+              break;
+            }
+            index = next_index++;
+          }
+
+          OutputBuffer result = generate(index);
+
+          std::lock_guard<std::mutex> queue_lock(queue_mutex);
+          finished.insert(std::make_pair(index, std::move(result)));
+          queue_filled.notify_one();
+        }
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> queue_lock(queue_mutex);
+        if (!failure)
+        {
+          failure = std::current_exception();
+        }
+        stop = true;
+        queue_drained.notify_all();
+      }
+
+      std::lock_guard<std::mutex> queue_lock(queue_mutex);
+      stopped_threads++;
+      queue_filled.notify_one();
+    };
+
+    try
+    {
+      for (size_t jThread = 0u; jThread < num_threads; jThread++)
+      {
+        workers.push_back(std::thread(worker));
+      }
+
+      while (consumed < count)
+      {
+        std::unique_lock<std::mutex> queue_lock(queue_mutex);
+        queue_filled.wait(queue_lock, [&]()
+        {
+          return stop || stopped_threads == workers.size() ||
+                 (in_order ? finished.count(consumed) > 0u : !finished.empty());
+        });
+        std::map<size_t, OutputBuffer>::iterator finished_itr = (in_order ? finished.find(consumed) : finished.begin());
+        if (stop || finished_itr == finished.end())
+        {
+          break;
+        }
+        std::pair<size_t, OutputBuffer> result = std::move(*finished_itr);
+        finished.erase(finished_itr);
+        consumed++;
+        queue_drained.notify_all();
+        queue_lock.unlock();
+
+        consume(result.first, result.second);
+      }
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> queue_lock(queue_mutex);
+      if (!failure)
+      {
+        failure = std::current_exception();
+      }
+      stop = true;
+      queue_drained.notify_all();
+    }
+
+    for (size_t jThread = 0u; jThread < workers.size(); jThread++)
+    {
+      workers.at(jThread).join();
+    }
+
+    if (failure)
+    {
+      std::rethrow_exception(failure);
+    }
+  }
+
+  /**
+   * Add a cell with a numeric value to this Sheet at the specified row & column.
    * integerref_t is a little inconvenient for the caller, so this interface is
    * provided to make things easier.
    */
-  void Sheet::add_string_cell(const uint32_t row, const uint32_t col, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  void Sheet::add_number_cell(const uint32_t row, const uint32_t col, const double number, const cell_style_t &cell_style) noexcept(false)
   {
     integerref_t integerref;
     integerref.row = row;
     integerref.col = col;
-    this->add_string_cell(integerref, value, cell_style);
+    this->add_number_cell(integerref, number, cell_style);
   }
 
   /**
-   * Add a cell with a string value to this Sheet at the specified row & column.
+   * Add a cell with a numeric value to this Sheet at the specified row & column.
+   * The style is registered with the Workbook first; see
+   * Workbook::registerStyle().
    */
-  void Sheet::add_string_cell(const integerref_t &integerref, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  void Sheet::add_number_cell(const integerref_t &integerref, const double number, const cell_style_t &cell_style) noexcept(false)
+  {
+    this->add_number_cell(integerref, number, workbook.registerStyle(cell_style));
+  }
+
+  /**
+   * Add a cell with a numeric value and a registered style to this Sheet at the specified row & column.
+   */
+  void Sheet::add_number_cell(const integerref_t &integerref, const double number, const StyleId style) noexcept(false)
   {
     if (integerref.col < 1u || 
         integerref.col > MAX_COL ||
         integerref.row < 1u ||
         integerref.row > MAX_ROW)
     {
-      throw std::invalid_argument(std::string("add_string_cell() received an invalid cell reference."));
-    }
-
-    if (value.length() > MAX_STRING_LEN)
-    {
-      throw std::invalid_argument(std::string("the string value supplied to add_string_cell() is too long."));
+      throw std::invalid_argument(std::string("add_number_cell() received an invalid cell reference."));
     }
 
-    if (std::count(value.begin(), value.end(), '\n') > MAX_STRING_LINE_BREAKS)
+    cell_t cell = {};
+    cell.col = integerref.col;
+    cell.type = CellType::NUMBER;
+    cell.style_index = workbook.styleIndex(style, "add_number_cell()");
+    cell.value.num_val = number;
+    
+    if (!insert_cell(integerref.row, cell))
     {
-      throw std::invalid_argument(std::string("the string value supplied to add_string_cell() contains too many line breaks."));
+      throw std::runtime_error(std::string("add_number_cell() encountered duplicate insertion of a cell at the same reference."));
     }
+    used_columns.insert(integerref.col);
+  }
 
-    cell_t cell = {0};
-    cell.integerref = integerref;
-    cell.type = CellType::STRING;
-    cell.style_index = workbook.addStyle(cell_style);
-    cell.str_fml_val = value;
-    cell.num_val = std::numeric_limits<double>::quiet_NaN();
+  /**
+   * Add a cell with a numeric value and a registered style to this Sheet
+   * at the specified row & column.
+   */
+  void Sheet::add_number_cell(const uint32_t row, const uint32_t col, const double number, const StyleId style) noexcept(false)
+  {
+    integerref_t integerref;
+    integerref.row = row;
+    integerref.col = col;
+    this->add_number_cell(integerref, number, style);
+  }
 
-    std::pair<std::set<cell_t,cell_sort_compare>::iterator, bool> insret = cells.insert(std::move(cell));
-    if (!insret.second)
-    {
-      throw std::runtime_error(std::string("add_string_cell() encountered duplicate insertion of a cell at the same reference."));
-    }
-    used_columns.insert(integerref.col);
+  /**
+   * Add a cell with a numeric value and a registered style to this Sheet
+   * at the specified cell reference in mixedref format.
+   */
+  void Sheet::add_number_cell(const std::string &mixedref, const double number, const StyleId style) noexcept(false)
+  {
+    integerref_t integerref = mixedref_to_integerref(mixedref);
+    this->add_number_cell(integerref, number, style);
   }
 
   /**
-   * Add a cell with a string value to this Sheet at the specified row & column.
+   * Add a cell with a numeric value to this Sheet at the specified row & column.
    * The caller may prefer to use mixedref format, especially if they are working
    * with formulas. This interface is provided to support that.
    */
-  void Sheet::add_string_cell(const std::string &mixedref, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  void Sheet::add_number_cell(const std::string &mixedref, const double number, const cell_style_t &cell_style) noexcept(false)
   {
     integerref_t integerref = mixedref_to_integerref(mixedref);
-    this->add_string_cell(integerref, value, cell_style);
+    this->add_number_cell(integerref, number, cell_style);
   }
 
   /**
    * Merge the cells bounded by start_ref (upper left corner) and end_ref
-   * (lower right corner) and put the string value in this merged cell.
+   * (lower right corner) and put the supplied numeric value in this merged cell.
    * integerref_t is a little inconvenient for the caller, so this interface is
    * provided to make things easier.
    */
-  void Sheet::add_merged_string_cell(const uint32_t start_row, const uint32_t start_col, const uint32_t end_row, const uint32_t end_col, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  void Sheet::add_merged_number_cell(const uint32_t start_row, const uint32_t start_col, const uint32_t end_row, const uint32_t end_col, const double number, const cell_style_t &cell_style) noexcept(false)
   {
     integerref_t start_ref;
     start_ref.row = start_row;
@@ -668,21 +1115,21 @@ namespace BasicWorkbook
     end_ref.row = end_row;
     end_ref.col = end_col;
 
-    this->add_merged_string_cell(start_ref, end_ref, value, cell_style);
+    this->add_merged_number_cell(start_ref, end_ref, number, cell_style);
   }
 
   /**
    * Merge the cells bounded by start_ref (upper left corner) and end_ref
-   * (lower right corner) and put the string value in this merged cell.
+   * (lower right corner) and put the supplied numeric value in this merged cell.
    */
-  void Sheet::add_merged_string_cell(const integerref_t &start_ref, const integerref_t &end_ref, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  void Sheet::add_merged_number_cell(const integerref_t &start_ref, const integerref_t &end_ref, const double number, const cell_style_t &cell_style) noexcept(false)
   {
     if (start_ref.col < 1u || 
         start_ref.col > MAX_COL ||
         start_ref.row < 1u ||
         start_ref.row > MAX_ROW)
     {
-      throw std::invalid_argument(std::string("add_merged_string_cell() received an invalid starting cell reference."));
+      throw std::invalid_argument(std::string("add_merged_number_cell() received an invalid starting cell reference."));
     }
 
     if (end_ref.col < 1u || 
@@ -690,7 +1137,7 @@ namespace BasicWorkbook
         end_ref.row < 1u ||
         end_ref.row > MAX_ROW)
     {
-      throw std::invalid_argument(std::string("add_merged_string_cell() received an invalid ending cell reference."));
+      throw std::invalid_argument(std::string("add_merged_number_cell() received an invalid ending cell reference."));
     }
 
     if (start_ref.col > end_ref.col || 
@@ -698,10 +1145,10 @@ namespace BasicWorkbook
         (start_ref.col == end_ref.col &&
          start_ref.row == end_ref.row))
     {
-      throw std::invalid_argument(std::string("add_merged_string_cell() received an ending cell reference equal or prior to its starting cell reference."));
+      throw std::invalid_argument(std::string("add_merged_number_cell() received an ending cell reference equal or prior to its starting cell reference."));
     }
 
-    this->add_string_cell(start_ref, value, cell_style);
+    this->add_number_cell(start_ref, number, cell_style);
 
     for (uint32_t jRow = start_ref.row; jRow <= end_ref.row; jRow++)
     {
@@ -727,299 +1174,2542 @@ namespace BasicWorkbook
 
   /**
    * Merge the cells bounded by start_ref (upper left corner) and end_ref
-   * (lower right corner) and put the string value in this merged cell.
+   * (lower right corner) and put the supplied numeric value in this merged cell.
    * The caller may prefer to use mixedref format, especially if they are working
    * with formulas. This interface is provided to support that.
    */
-  void Sheet::add_merged_string_cell(const std::string &start_ref, const std::string &end_ref, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  void Sheet::add_merged_number_cell(const std::string &start_ref, const std::string &end_ref, const double number, const cell_style_t &cell_style) noexcept(false)
   {
     integerref_t int_start_ref = mixedref_to_integerref(start_ref);
     integerref_t int_end_ref = mixedref_to_integerref(end_ref);
 
-    this->add_merged_string_cell(int_start_ref, int_end_ref, value, cell_style);
+    this->add_merged_number_cell(int_start_ref, int_end_ref, number, cell_style);
   }
 
   /**
-   * Set the width of the indicated column in terms of number of characters
-   * of the width of the widest digit character (0, 1, ..., 9) in the present
-   * font. The ECMA376 standard has equations to accurately scale this value
-   * to account for the 5 pixel padding in the column.
-   *
-   * This value is only actually applied to columns that have at least one
+   * Add a cell with a formula to this Sheet at the specified row & column.
+   * integerref_t is a little inconvenient for the caller, so this interface is
+   * provided to make things easier.
+   */
+  void Sheet::add_formula_cell(const uint32_t row, const uint32_t col, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t integerref;
+    integerref.row = row;
+    integerref.col = col;
+    this->add_formula_cell(integerref, formula, cell_style);
+  }
+
+  /**
+   * Add a cell with a formula to this Sheet at the specified row & column.
+   * The style is registered with the Workbook first; see
+   * Workbook::registerStyle().
+   */
+  void Sheet::add_formula_cell(const integerref_t &integerref, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  {
+    this->add_formula_cell(integerref, formula, workbook.registerStyle(cell_style));
+  }
+
+  /**
+   * Add a cell with a formula and a registered style to this Sheet at the specified row & column.
+   */
+  void Sheet::add_formula_cell(const integerref_t &integerref, const std::string &formula, const StyleId style) noexcept(false)
+  {
+    if (integerref.col < 1u || 
+        integerref.col > MAX_COL ||
+        integerref.row < 1u ||
+        integerref.row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string("add_formula_cell() received an invalid cell reference."));
+    }
+
+    if (formula.length() > MAX_FORMULA_LEN)
+    {
+      throw std::invalid_argument(std::string("the formula supplied to add_formula_cell() is too long."));
+    }
+
+    cell_t cell = {};
+    cell.col = integerref.col;
+    cell.type = CellType::FORMULA;
+    cell.style_index = workbook.styleIndex(style, "add_formula_cell()");
+    if (formula_text.size() + formula.size() > std::numeric_limits<uint32_t>::max())
+    {
+      throw std::runtime_error(std::string("add_formula_cell() ran out of room for formula text in this Sheet."));
+    }
+    if (formula_text.capacity() == 0u)
+    {
+      formula_text = workbook.takeBuffer();
+    }
+    cell.value.formula.offset = static_cast<uint32_t>(formula_text.size());
+    cell.value.formula.length = static_cast<uint32_t>(formula.size());
+
+    if (!insert_cell(integerref.row, cell))
+    {
+      throw std::runtime_error(std::string("add_formula_cell() encountered duplicate insertion of a cell at the same reference."));
+    }
+    formula_text.append(formula);
+    used_columns.insert(integerref.col);
+  }
+
+  /**
+   * Add a cell with a formula and a registered style to this Sheet
+   * at the specified row & column.
+   */
+  void Sheet::add_formula_cell(const uint32_t row, const uint32_t col, const std::string &formula, const StyleId style) noexcept(false)
+  {
+    integerref_t integerref;
+    integerref.row = row;
+    integerref.col = col;
+    this->add_formula_cell(integerref, formula, style);
+  }
+
+  /**
+   * Add a cell with a formula and a registered style to this Sheet
+   * at the specified cell reference in mixedref format.
+   */
+  void Sheet::add_formula_cell(const std::string &mixedref, const std::string &formula, const StyleId style) noexcept(false)
+  {
+    integerref_t integerref = mixedref_to_integerref(mixedref);
+    this->add_formula_cell(integerref, formula, style);
+  }
+
+  /**
+   * Add a cell with a formula to this Sheet at the specified row & column.
+   * The caller may prefer to use mixedref format, especially if they are working
+   * with formulas. This interface is provided to support that.
+   */
+  void Sheet::add_formula_cell(const std::string &mixedref, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t integerref = mixedref_to_integerref(mixedref);
+    this->add_formula_cell(integerref, formula, cell_style);
+  }
+
+  /**
+   * Merge the cells bounded by start_ref (upper left corner) and end_ref
+   * (lower right corner) and put the supplied formula in this merged cell.
+   * integerref_t is a little inconvenient for the caller, so this interface is
+   * provided to make things easier.
+   */
+  void Sheet::add_merged_formula_cell(const uint32_t start_row, const uint32_t start_col, const uint32_t end_row, const uint32_t end_col, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t start_ref;
+    start_ref.row = start_row;
+    start_ref.col = start_col;
+
+    integerref_t end_ref;
+    end_ref.row = end_row;
+    end_ref.col = end_col;
+
+    this->add_merged_formula_cell(start_ref, end_ref, formula, cell_style);
+  }
+
+  /**
+   * Merge the cells bounded by start_ref (upper left corner) and end_ref
+   * (lower right corner) and put the supplied formula in this merged cell.
+   */
+  void Sheet::add_merged_formula_cell(const integerref_t &start_ref, const integerref_t &end_ref, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  {
+    if (start_ref.col < 1u || 
+        start_ref.col > MAX_COL ||
+        start_ref.row < 1u ||
+        start_ref.row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string("add_merged_formula_cell() received an invalid starting cell reference."));
+    }
+
+    if (end_ref.col < 1u || 
+        end_ref.col > MAX_COL ||
+        end_ref.row < 1u ||
+        end_ref.row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string("add_merged_formula_cell() received an invalid ending cell reference."));
+    }
+
+    if (start_ref.col > end_ref.col || 
+        start_ref.row > end_ref.row ||
+        (start_ref.col == end_ref.col &&
+         start_ref.row == end_ref.row))
+    {
+      throw std::invalid_argument(std::string("add_merged_formula_cell() received an ending cell reference equal or prior to its starting cell reference."));
+    }
+
+    this->add_formula_cell(start_ref, formula, cell_style);
+
+    for (uint32_t jRow = start_ref.row; jRow <= end_ref.row; jRow++)
+    {
+      for (uint32_t jCol = start_ref.col; jCol <= end_ref.col; jCol++)
+      {
+        if (jRow == start_ref.row && jCol == start_ref.col)
+        {
+          continue;
+        }
+
+        integerref_t this_ref;
+        this_ref.row = jRow;
+        this_ref.col = jCol;
+        this->add_empty_cell(this_ref, cell_style);
+      }
+    }
+
+    merged_cell_t this_merge;
+    this_merge.start_ref = start_ref;
+    this_merge.end_ref = end_ref;
+    merged_cells.insert(std::move(this_merge));
+  }
+
+  /**
+   * Merge the cells bounded by start_ref (upper left corner) and end_ref
+   * (lower right corner) and put the supplied formula in this merged cell.
+   * The caller may prefer to use mixedref format, especially if they are working
+   * with formulas. This interface is provided to support that.
+   */
+  void Sheet::add_merged_formula_cell(const std::string &start_ref, const std::string &end_ref, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t int_start_ref = mixedref_to_integerref(start_ref);
+    integerref_t int_end_ref = mixedref_to_integerref(end_ref);
+
+    this->add_merged_formula_cell(int_start_ref, int_end_ref, formula, cell_style);
+  }
+
+  /**
+   * Add a cell with a string value to this Sheet at the specified row & column.
+   * integerref_t is a little inconvenient for the caller, so this interface is
+   * provided to make things easier.
+   */
+  void Sheet::add_string_cell(const uint32_t row, const uint32_t col, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t integerref;
+    integerref.row = row;
+    integerref.col = col;
+    this->add_string_cell(integerref, value, cell_style);
+  }
+
+  /**
+   * Add a cell with a string value to this Sheet at the specified row & column.
+   * The style is registered with the Workbook first; see
+   * Workbook::registerStyle().
+   */
+  void Sheet::add_string_cell(const integerref_t &integerref, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  {
+    this->add_string_cell(integerref, value, workbook.registerStyle(cell_style));
+  }
+
+  /**
+   * Add a cell with a string value and a registered style to this Sheet at the specified row & column.
+   */
+  void Sheet::add_string_cell(const integerref_t &integerref, const std::string &value, const StyleId style) noexcept(false)
+  {
+    if (integerref.col < 1u || 
+        integerref.col > MAX_COL ||
+        integerref.row < 1u ||
+        integerref.row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string("add_string_cell() received an invalid cell reference."));
+    }
+
+    check_string_value(value, "add_string_cell()");
+
+    cell_t cell = {};
+    cell.col = integerref.col;
+    cell.type = CellType::STRING;
+    cell.style_index = workbook.styleIndex(style, "add_string_cell()");
+
+    // Reject a duplicate before interning so that a failed insertion
+    // leaves the string pool and the column statistics untouched.
+    if (!run_is_free(integerref.row, integerref.col, 1u))
+    {
+      throw std::runtime_error(std::string("add_string_cell() encountered duplicate insertion of a cell at the same reference."));
+    }
+    if (string_columns.size() <= integerref.col)
+    {
+      string_columns.resize(integerref.col + 1u);
+    }
+    cell.value.text_index = workbook.internString(value, string_columns[integerref.col]);
+
+    insert_cell(integerref.row, cell);
+    used_columns.insert(integerref.col);
+  }
+
+  /**
+   * Add a cell with a string value and a registered style to this Sheet
+   * at the specified row & column.
+   */
+  void Sheet::add_string_cell(const uint32_t row, const uint32_t col, const std::string &value, const StyleId style) noexcept(false)
+  {
+    integerref_t integerref;
+    integerref.row = row;
+    integerref.col = col;
+    this->add_string_cell(integerref, value, style);
+  }
+
+  /**
+   * Add a cell with a string value and a registered style to this Sheet
+   * at the specified cell reference in mixedref format.
+   */
+  void Sheet::add_string_cell(const std::string &mixedref, const std::string &value, const StyleId style) noexcept(false)
+  {
+    integerref_t integerref = mixedref_to_integerref(mixedref);
+    this->add_string_cell(integerref, value, style);
+  }
+
+  /**
+   * Add a cell with a string value to this Sheet at the specified row & column.
+   * The caller may prefer to use mixedref format, especially if they are working
+   * with formulas. This interface is provided to support that.
+   */
+  void Sheet::add_string_cell(const std::string &mixedref, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t integerref = mixedref_to_integerref(mixedref);
+    this->add_string_cell(integerref, value, cell_style);
+  }
+
+  /**
+   * Merge the cells bounded by start_ref (upper left corner) and end_ref
+   * (lower right corner) and put the string value in this merged cell.
+   * integerref_t is a little inconvenient for the caller, so this interface is
+   * provided to make things easier.
+   */
+  void Sheet::add_merged_string_cell(const uint32_t start_row, const uint32_t start_col, const uint32_t end_row, const uint32_t end_col, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t start_ref;
+    start_ref.row = start_row;
+    start_ref.col = start_col;
+
+    integerref_t end_ref;
+    end_ref.row = end_row;
+    end_ref.col = end_col;
+
+    this->add_merged_string_cell(start_ref, end_ref, value, cell_style);
+  }
+
+  /**
+   * Merge the cells bounded by start_ref (upper left corner) and end_ref
+   * (lower right corner) and put the string value in this merged cell.
+   */
+  void Sheet::add_merged_string_cell(const integerref_t &start_ref, const integerref_t &end_ref, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  {
+    if (start_ref.col < 1u || 
+        start_ref.col > MAX_COL ||
+        start_ref.row < 1u ||
+        start_ref.row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string("add_merged_string_cell() received an invalid starting cell reference."));
+    }
+
+    if (end_ref.col < 1u || 
+        end_ref.col > MAX_COL ||
+        end_ref.row < 1u ||
+        end_ref.row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string("add_merged_string_cell() received an invalid ending cell reference."));
+    }
+
+    if (start_ref.col > end_ref.col || 
+        start_ref.row > end_ref.row ||
+        (start_ref.col == end_ref.col &&
+         start_ref.row == end_ref.row))
+    {
+      throw std::invalid_argument(std::string("add_merged_string_cell() received an ending cell reference equal or prior to its starting cell reference."));
+    }
+
+    this->add_string_cell(start_ref, value, cell_style);
+
+    for (uint32_t jRow = start_ref.row; jRow <= end_ref.row; jRow++)
+    {
+      for (uint32_t jCol = start_ref.col; jCol <= end_ref.col; jCol++)
+      {
+        if (jRow == start_ref.row && jCol == start_ref.col)
+        {
+          continue;
+        }
+
+        integerref_t this_ref;
+        this_ref.row = jRow;
+        this_ref.col = jCol;
+        this->add_empty_cell(this_ref, cell_style);
+      }
+    }
+
+    merged_cell_t this_merge;
+    this_merge.start_ref = start_ref;
+    this_merge.end_ref = end_ref;
+    merged_cells.insert(std::move(this_merge));
+  }
+
+  /**
+   * Merge the cells bounded by start_ref (upper left corner) and end_ref
+   * (lower right corner) and put the string value in this merged cell.
+   * The caller may prefer to use mixedref format, especially if they are working
+   * with formulas. This interface is provided to support that.
+   */
+  void Sheet::add_merged_string_cell(const std::string &start_ref, const std::string &end_ref, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t int_start_ref = mixedref_to_integerref(start_ref);
+    integerref_t int_end_ref = mixedref_to_integerref(end_ref);
+
+    this->add_merged_string_cell(int_start_ref, int_end_ref, value, cell_style);
+  }
+
+  /**
+   * Add count number cells with the registered style to row row of
+   * this Sheet, in consecutive columns starting at first_col.
+   * values[j] goes in column first_col + j. The arguments are
+   * checked once for the whole row and the values are copied
+   * straight into the Sheet's cell storage. If any of the cells
+   * already exists, nothing is added.
+   */
+  void Sheet::add_row(const uint32_t row, const uint32_t first_col, const double *values, const size_t count, const StyleId style) noexcept(false)
+  {
+    insert_number_block("add_row()", row, first_col, 1u, static_cast<uint32_t>(std::min(count, static_cast<size_t>(MAX_COL) + 1u)), values, count, style);
+  }
+
+  /**
+   * Add count string cells with the registered style to row row of
+   * this Sheet, in consecutive columns starting at first_col.
+   * values[j] goes in column first_col + j. If any of the cells
+   * already exists, nothing is added.
+   */
+  void Sheet::add_row(const uint32_t row, const uint32_t first_col, const std::string *values, const size_t count, const StyleId style) noexcept(false)
+  {
+    insert_string_block("add_row()", row, first_col, 1u, static_cast<uint32_t>(std::min(count, static_cast<size_t>(MAX_COL) + 1u)), values, count, style);
+  }
+
+  /**
+   * Add a rows x cols block of number cells with the registered
+   * style to this Sheet, with its upper left cell at row, col.
+   * The value of the cell at row + r, col + c is
+   * values[r * stride + c], so stride is at least cols. The
+   * arguments are checked once for the whole block and the values
+   * of each row are copied straight into the Sheet's cell storage.
+   * If any of the cells already exists, nothing is added.
+   */
+  void Sheet::add_block(const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const double *values, const size_t stride, const StyleId style) noexcept(false)
+  {
+    insert_number_block("add_block()", row, col, rows, cols, values, stride, style);
+  }
+
+  /**
+   * Add a rows x cols block of string cells with the registered
+   * style to this Sheet, with its upper left cell at row, col.
+   * The value of the cell at row + r, col + c is
+   * values[r * stride + c], so stride is at least cols. If any of
+   * the values is not a valid string cell value or any of the
+   * cells already exists, nothing is added.
+   */
+  void Sheet::add_block(const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const std::string *values, const size_t stride, const StyleId style) noexcept(false)
+  {
+    insert_string_block("add_block()", row, col, rows, cols, values, stride, style);
+  }
+
+  /**
+   * Add a rows x cols block of number cells with the registered
+   * style to this Sheet from column-major data, with its upper left
+   * cell at row, col. columns holds cols pointers, one per column,
+   * and the value of the cell at row + r, col + c is columns[c][r].
+   *
+   * The block is inserted one cell block (CELL_BLOCK_ROWS rows) at
+   * a time: the rows' runs of cells are inserted like add_row() and
+   * the values then transposed straight into them,
+   * TRANSPOSE_TILE_COLS columns at a time. No row-major copy of the
+   * block is made. If any of the cells already exists, nothing is
+   * added.
+   */
+  void Sheet::add_columns(const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const double *const *columns, const StyleId style) noexcept(false)
+  {
+    const uint16_t style_index = workbook.styleIndex(style, "add_columns()");
+    if (!check_block(row, col, rows, cols, columns, cols, "add_columns()"))
+    {
+      return;
+    }
+    check_columns(columns, cols, "add_columns()");
+
+    std::pmr::vector<size_t> run_offsets(workbook.memory);
+    uint32_t group_start = 0u;
+    while (group_start < rows)
+    {
+      const uint32_t group_rows = block_group_rows(row + group_start, rows - group_start);
+      cell_value_t *block_values = insert_group_runs(row + group_start, group_rows, col, cols, style_index, CellType::NUMBER, run_offsets);
+
+      for (uint32_t tile_col = 0u; tile_col < cols; tile_col += TRANSPOSE_TILE_COLS)
+      {
+        const uint32_t tile_end = std::min(cols, tile_col + TRANSPOSE_TILE_COLS);
+        for (uint32_t jRow = 0u; jRow < group_rows; jRow++)
+        {
+          cell_value_t *cell_values = block_values + run_offsets[jRow];
+          for (uint32_t jCol = tile_col; jCol < tile_end; jCol++)
+          {
+            cell_values[jCol].num_val = columns[jCol][group_start + jRow];
+          }
+        }
+      }
+
+      group_start += group_rows;
+    }
+    add_used_columns(col, cols);
+  }
+
+  /**
+   * Add a rows x cols block of string cells with the registered
+   * style to this Sheet from column-major data, with its upper left
+   * cell at row, col. columns holds cols pointers, one per column,
+   * and the value of the cell at row + r, col + c is columns[c][r].
+   *
+   * Each column is read top to bottom, one cell block at a time,
+   * after the rows' runs of cells are inserted like add_row(), and
+   * its values interned straight into those cells. If any of the
+   * values is not a valid string cell value or any of the cells
+   * already exists, nothing is added.
+   */
+  void Sheet::add_columns(const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const std::string *const *columns, const StyleId style) noexcept(false)
+  {
+    const uint16_t style_index = workbook.styleIndex(style, "add_columns()");
+    if (!check_block(row, col, rows, cols, columns, cols, "add_columns()"))
+    {
+      return;
+    }
+    check_columns(columns, cols, "add_columns()");
+
+    for (uint32_t jCol = 0u; jCol < cols; jCol++)
+    {
+      for (uint32_t jRow = 0u; jRow < rows; jRow++)
+      {
+        check_string_value(columns[jCol][jRow], "add_columns()");
+      }
+    }
+
+    if (string_columns.size() <= col + cols - 1u)
+    {
+      string_columns.resize(col + cols);
+    }
+
+    std::pmr::vector<size_t> run_offsets(workbook.memory);
+    uint32_t group_start = 0u;
+    while (group_start < rows)
+    {
+      const uint32_t group_rows = block_group_rows(row + group_start, rows - group_start);
+      cell_value_t *block_values = insert_group_runs(row + group_start, group_rows, col, cols, style_index, CellType::STRING, run_offsets);
+
+      for (uint32_t jCol = 0u; jCol < cols; jCol++)
+      {
+        string_column_stats_t &column_stats = string_columns[col + jCol];
+        const std::string *column = columns[jCol] + group_start;
+        for (uint32_t jRow = 0u; jRow < group_rows; jRow++)
+        {
+          block_values[run_offsets[jRow] + jCol].text_index = workbook.internString(column[jRow], column_stats);
+        }
+      }
+
+      group_start += group_rows;
+    }
+    add_used_columns(col, cols);
+  }
+
+  /**
+   * Shared by add_row() and add_block() for number cells. caller
+   * names the public method for exception messages.
+   */
+  void Sheet::insert_number_block(const char *caller, const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const double *values, const size_t stride, const StyleId style) noexcept(false)
+  {
+    const uint16_t style_index = workbook.styleIndex(style, caller);
+    if (!check_block(row, col, rows, cols, values, stride, caller))
+    {
+      return;
+    }
+
+    for (uint32_t jRow = 0u; jRow < rows; jRow++)
+    {
+      cell_value_t *cell_values = insert_run(row + jRow, col, cols, style_index, CellType::NUMBER);
+      const double *row_values = values + jRow * stride;
+      for (uint32_t jCol = 0u; jCol < cols; jCol++)
+      {
+        cell_values[jCol].num_val = row_values[jCol];
+      }
+    }
+    add_used_columns(col, cols);
+  }
+
+  /**
+   * Shared by add_row() and add_block() for string cells. caller
+   * names the public method for exception messages.
+   */
+  void Sheet::insert_string_block(const char *caller, const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const std::string *values, const size_t stride, const StyleId style) noexcept(false)
+  {
+    const uint16_t style_index = workbook.styleIndex(style, caller);
+    if (!check_block(row, col, rows, cols, values, stride, caller))
+    {
+      return;
+    }
+
+    for (uint32_t jRow = 0u; jRow < rows; jRow++)
+    {
+      for (uint32_t jCol = 0u; jCol < cols; jCol++)
+      {
+        check_string_value(values[jRow * stride + jCol], caller);
+      }
+    }
+
+    if (string_columns.size() <= col + cols - 1u)
+    {
+      string_columns.resize(col + cols);
+    }
+
+    for (uint32_t jRow = 0u; jRow < rows; jRow++)
+    {
+      cell_value_t *cell_values = insert_run(row + jRow, col, cols, style_index, CellType::STRING);
+      const std::string *row_values = values + jRow * stride;
+      for (uint32_t jCol = 0u; jCol < cols; jCol++)
+      {
+        cell_values[jCol].text_index = workbook.internString(row_values[jCol], string_columns[col + jCol]);
+      }
+    }
+    add_used_columns(col, cols);
+  }
+
+  /**
+   * Shared by insert_number_block() and insert_string_block(): checks the
+   * position and shape of a block and that none of its cells
+   * exists yet. Returns false for an empty block, which adds
+   * nothing. caller names the public method for exception messages.
+   */
+  bool Sheet::check_block(const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const void *values, const size_t stride, const char *caller) const noexcept(false)
+  {
+    if (rows == 0u || cols == 0u)
+    {
+      return false;
+    }
+
+    if (col < 1u ||
+        col > MAX_COL ||
+        row < 1u ||
+        row > MAX_ROW ||
+        cols > MAX_COL - col + 1u ||
+        rows > MAX_ROW - row + 1u)
+    {
+      throw std::invalid_argument(std::string(caller) + " received cells outside the sheet.");
+    }
+
+    if (values == nullptr || stride < cols)
+    {
+      throw std::invalid_argument(std::string(caller) + " received a null values pointer or a stride smaller than the block width.");
+    }
+
+    for (uint32_t jRow = 0u; jRow < rows; jRow++)
+    {
+      if (!run_is_free(row + jRow, col, cols))
+      {
+        throw std::runtime_error(std::string(caller) + " encountered duplicate insertion of a cell at the same reference.");
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Returns how many of the next rows rows, starting at row row,
+   * fall in the same cell block as row.
+   */
+  uint32_t Sheet::block_group_rows(const uint32_t row, const uint32_t rows) const noexcept
+  {
+    const uint32_t block_end = ((row - 1u) / CELL_BLOCK_ROWS + 1u) * CELL_BLOCK_ROWS + 1u;
+    return std::min(rows, block_end - row);
+  }
+
+  /**
+   * Records columns first_col to first_col+count-1 as used.
+   */
+  void Sheet::add_used_columns(const uint32_t first_col, const uint32_t count) noexcept(false)
+  {
+    std::pmr::set<uint32_t>::iterator hint = used_columns.end();
+    for (uint32_t jCol = first_col + count; jCol > first_col; jCol--)
+    {
+      hint = used_columns.insert(hint, jCol - 1u);
+    }
+  }
+
+  /**
+   * Set the width of the indicated column in terms of number of characters
+   * of the width of the widest digit character (0, 1, ..., 9) in the present
+   * font. The ECMA376 standard has equations to accurately scale this value
+   * to account for the 5 pixel padding in the column.
+   *
+   * This value is only actually applied to columns that have at least one
+   * non-empty cell.
+   */
+  void Sheet::set_column_width(const uint32_t col, const double width) noexcept(false)
+  {
+    if (width < MIN_COL_WIDTH || width > MAX_COL_WIDTH)
+    {
+      throw std::invalid_argument(std::string("set_column_width() received invalid width argument."));
+    }
+
+    if (col < 1u || col > MAX_COL)
+    {
+      throw std::invalid_argument(std::string("set_column_width() received invalid col argument."));
+    }
+
+    column_widths.insert(std::make_pair(col, width));
+  }
+
+  /**
+   * Alternative option for set_column_width that accepts the column index
+   * in the format A, B, ..., Z, AA, AB, ...
+   */
+  void Sheet::set_column_width(const std::string &column, const double width) noexcept(false)
+  {
+    uint32_t col = column_to_integer(column);
+    this->set_column_width(col, width);
+  }
+
+  /**
+   * Set the heights of the indicated row in points.
+   *
+   * This value is only actually applied to columns that have at least one
    * non-empty cell.
    */
-  void Sheet::set_column_width(const uint32_t col, const double width) noexcept(false)
+  void Sheet::set_row_height(const uint32_t row, const double height) noexcept(false)
+  {
+    if (height < MIN_ROW_HEIGHT || height > MAX_ROW_HEIGHT)
+    {
+      throw std::invalid_argument(std::string("set_row_height() received invalid height argument."));
+    }
+
+    if (row < 1u || row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string("set_row_height() received invalid row argument."));
+    }
+
+    row_heights.insert(std::make_pair(row, height));
+  }
+
+  /**
+   * Retrieve the name of this Sheet; this is the name displayed
+   * on the Sheet's tab in a popular office software suite.
+   */
+  std::string Sheet::get_name(void) const noexcept
+  {
+    return name;
+  }
+
+  /**
+   * Private Sheet constructor called by Workbook::addSheet().
+   * The thought is that the user of this program shouldn't have to manage
+   * filenames, sheetIds, and relIds within the workbook. They still get to
+   * name the Sheet, since name is displayed on the Sheet's tab in a
+   * popular office software suite.
+   */
+  Sheet::Sheet(const std::string &name_, const std::string &filename_, const uint32_t sheetId_, const std::string &relId_, Workbook &workbook_) noexcept(false) :
+    workbook(workbook_), name(name_), filename(filename_), sheetId(sheetId_), relId(relId_), used_columns(workbook_.memory), column_widths(workbook_.memory),
+    row_heights(workbook_.memory), cell_blocks(workbook_.memory), formula_text(workbook_.memory), string_columns(workbook_.memory), shared_columns(workbook_.memory),
+    merged_cells(workbook_.memory)
+  {
+    /* Nothing. */
+  }
+
+  /**
+   * Adds an empty cell to the sheet. Used for all cell references except
+   * the upper left reference in a merged cell.
+   */
+  void Sheet::add_empty_cell(const integerref_t &integerref, const cell_style_t &cell_style) noexcept(false)
+  {
+    if (integerref.col < 1u || 
+        integerref.col > MAX_COL ||
+        integerref.row < 1u ||
+        integerref.row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string("add_empty_cell() received an invalid cell reference."));
+    }
+
+    cell_t cell = {};
+    cell.col = integerref.col;
+    cell.type = CellType::EMPTY;
+    cell.style_index = static_cast<uint16_t>(workbook.addStyle(cell_style));
+    cell.value.num_val = std::numeric_limits<double>::quiet_NaN();
+
+    if (!insert_cell(integerref.row, cell))
+    {
+      throw std::runtime_error(std::string("add_empty_cell() encountered duplicate insertion of a cell at the same reference."));
+    }
+    used_columns.insert(integerref.col);
+  }
+
+  /**
+   * Places cell in row row of this Sheet, keeping the cell blocks,
+   * the rows within each block and each row's cells sorted. Returns
+   * false, leaving the Sheet unchanged, if a cell already exists at
+   * the same reference.
+   */
+  bool Sheet::insert_cell(const uint32_t row, const cell_t &cell) noexcept(false)
+  {
+    cell_value_t *value = insert_run(row, cell.col, 1u, cell.style_index, cell.type);
+    if (value == nullptr)
+    {
+      return false;
+    }
+    *value = cell.value;
+    return true;
+  }
+
+  /**
+   * Places count cells of type type and style style_index in row
+   * row of this Sheet, in columns first_col to first_col+count-1,
+   * keeping the cell blocks, the rows within each block and each
+   * row's cells sorted. Returns a pointer to the count consecutive
+   * values of the new cells, which the caller fills in, or nullptr,
+   * leaving the Sheet unchanged, if any of the columns already has
+   * a cell in that row. The pointer is valid until the next cell
+   * is added.
+   *
+   * Cells are almost always added in row-major order, so the common
+   * case appends to the last row of the last block in O(count).
+   * Anything else falls back to a binary search and an insertion,
+   * which only shifts cells within a single block.
+   */
+  cell_value_t* Sheet::insert_run(const uint32_t row, const uint32_t first_col, const uint32_t count, const uint16_t style_index, const CellType type) noexcept(false)
+  {
+    const uint32_t block_index = (row - 1u) / CELL_BLOCK_ROWS;
+    std::pmr::vector<cell_block_t>::iterator block_itr;
+    if (cell_blocks.empty() || cell_blocks.back().block_index < block_index)
+    {
+      cell_blocks.push_back(workbook.takeBlock());
+      cell_blocks.back().block_index = block_index;
+      block_itr = cell_blocks.end() - 1;
+    }
+    else if (cell_blocks.back().block_index == block_index)
+    {
+      block_itr = cell_blocks.end() - 1;
+    }
+    else
+    {
+      block_itr = std::lower_bound(cell_blocks.begin(), cell_blocks.end(), block_index,
+        [](const cell_block_t &a, const uint32_t b) { return a.block_index < b; });
+      if (block_itr->block_index != block_index)
+      {
+        block_itr = cell_blocks.insert(block_itr, workbook.takeBlock());
+        block_itr->block_index = block_index;
+      }
+    }
+    cell_block_t &block = *block_itr;
+
+    size_t row_pos = block.rows.size();
+    if (block.rows.empty() || block.rows.back() < row)
+    {
+      block.rows.push_back(row);
+      block.row_starts.push_back(static_cast<uint32_t>(block.cols.size()));
+    }
+    else
+    {
+      row_pos = std::lower_bound(block.rows.begin(), block.rows.end(), row) - block.rows.begin();
+      if (block.rows[row_pos] != row)
+      {
+        const uint32_t row_start = block.row_starts[row_pos];
+        block.rows.insert(block.rows.begin() + row_pos, row);
+        block.row_starts.insert(block.row_starts.begin() + row_pos, row_start);
+      }
+    }
+
+    const size_t row_begin = block.row_starts[row_pos];
+    const size_t row_end = (row_pos + 1u < block.rows.size()) ? block.row_starts[row_pos + 1u] : block.cols.size();
+    size_t cell_pos = row_end;
+    if (row_begin != row_end && block.cols[row_end - 1u] >= first_col)
+    {
+      cell_pos = std::lower_bound(block.cols.begin() + row_begin, block.cols.begin() + row_end, first_col) - block.cols.begin();
+      if (cell_pos < row_end && block.cols[cell_pos] < first_col + count)
+      {
+        return nullptr;
+      }
+    }
+
+    block.cols.insert(block.cols.begin() + cell_pos, count, 0u);
+    std::iota(block.cols.begin() + cell_pos, block.cols.begin() + cell_pos + count, first_col);
+    block.style_indices.insert(block.style_indices.begin() + cell_pos, count, style_index);
+    block.types.insert(block.types.begin() + cell_pos, count, type);
+    block.values.insert(block.values.begin() + cell_pos, count, cell_value_t());
+    for (size_t jRow = row_pos + 1u; jRow < block.rows.size(); jRow++)
+    {
+      block.row_starts[jRow] += count;
+    }
+
+    return &block.values[cell_pos];
+  }
+
+  /**
+   * Inserts a run of count cells at first_col into each of rows
+   * rows starting at row, which must all lie in one cell block and
+   * be free. Sets run_offsets[r] to the position of row row + r's
+   * run in the block's values and returns those values, which stay
+   * valid until the block is next changed.
+   */
+  cell_value_t* Sheet::insert_group_runs(const uint32_t row, const uint32_t rows, const uint32_t first_col, const uint32_t count, const uint16_t style_index, const CellType type, std::pmr::vector<size_t> &run_offsets) noexcept(false)
+  {
+    run_offsets.resize(rows);
+    cell_value_t *cell_values = insert_run(row, first_col, count, style_index, type);
+
+    const uint32_t block_index = (row - 1u) / CELL_BLOCK_ROWS;
+    std::pmr::vector<cell_block_t>::iterator block_itr = cell_blocks.end() - 1;
+    if (block_itr->block_index != block_index)
+    {
+      block_itr = std::lower_bound(cell_blocks.begin(), cell_blocks.end(), block_index,
+        [](const cell_block_t &a, const uint32_t b) { return a.block_index < b; });
+    }
+    const cell_block_t &block = *block_itr;
+
+    // A row's cells follow those of the rows above it, so inserting
+    // a later run never moves an earlier one, although the values
+    // array itself may be reallocated.
+    run_offsets[0] = static_cast<size_t>(cell_values - block.values.data());
+    for (uint32_t jRow = 1u; jRow < rows; jRow++)
+    {
+      cell_values = insert_run(row + jRow, first_col, count, style_index, type);
+      run_offsets[jRow] = static_cast<size_t>(cell_values - block.values.data());
+    }
+    return block_itr->values.data();
+  }
+
+  /**
+   * Returns true if none of columns first_col to first_col+count-1
+   * of row row holds a cell yet.
+   */
+  bool Sheet::run_is_free(const uint32_t row, const uint32_t first_col, const uint32_t count) const noexcept
+  {
+    const uint32_t block_index = (row - 1u) / CELL_BLOCK_ROWS;
+    if (cell_blocks.empty() || cell_blocks.back().block_index < block_index)
+    {
+      return true;
+    }
+
+    std::pmr::vector<cell_block_t>::const_iterator block_itr = std::lower_bound(cell_blocks.begin(), cell_blocks.end(), block_index,
+      [](const cell_block_t &a, const uint32_t b) { return a.block_index < b; });
+    if (block_itr->block_index != block_index)
+    {
+      return true;
+    }
+    const cell_block_t &block = *block_itr;
+
+    std::pmr::vector<uint32_t>::const_iterator row_itr = std::lower_bound(block.rows.begin(), block.rows.end(), row);
+    if (row_itr == block.rows.end() || *row_itr != row)
+    {
+      return true;
+    }
+
+    const size_t row_pos = static_cast<size_t>(row_itr - block.rows.begin());
+    const size_t row_end = (row_pos + 1u < block.rows.size()) ? block.row_starts[row_pos + 1u] : block.cols.size();
+    std::pmr::vector<uint32_t>::const_iterator col_itr = std::lower_bound(block.cols.begin() + block.row_starts[row_pos], block.cols.begin() + row_end, first_col);
+    return col_itr == block.cols.begin() + row_end || *col_itr >= first_col + count;
+  }
+
+  /**
+   * Appends the contents of this Sheet's xml file inside the
+   * actual workbook ZIP archive to file, after reserving room for
+   * all of it up front. compact leaves out redundant cell
+   * attributes; see put_cell_start().
+   */
+  void Sheet::generate_file(OutputBuffer &file, const bool compact) const noexcept(false)
+  {
+    file.reserve(file.size() + estimate_file_size() + estimate_rows_size(0u, cell_blocks.size(), compact));
+    append_file_start(file);
+    append_rows(file, 0u, cell_blocks.size(), compact);
+    append_file_end(file);
+  }
+
+  /**
+   * Writes this Sheet's xml file straight into the Workbook
+   * archive in chunks of about STREAM_BUFFER_SIZE bytes, using
+   * chunk as the buffer, so the file is never held whole. compact
+   * leaves out redundant cell attributes; see put_cell_start().
+   */
+  void Sheet::write_file(OutputBuffer &chunk, const bool compact) const noexcept(false)
+  {
+    workbook.archive.beginFile(filename);
+    chunk.clear();
+    chunk.reserve(2u * STREAM_BUFFER_SIZE);
+    append_file_start(chunk);
+    append_rows(chunk, 0u, cell_blocks.size(), compact, &workbook.archive);
+    append_file_end(chunk);
+    workbook.archive.writeFileData(chunk.data(), chunk.size());
+    workbook.archive.endFile();
+    chunk.clear();
+  }
+
+  /**
+   * An upper estimate of the size of everything in this Sheet's
+   * xml file except the rows themselves (see estimate_rows_size()).
+   */
+  size_t Sheet::estimate_file_size(void) const noexcept
+  {
+    return 512u +
+           72u * used_columns.size() +
+           48u * (merged_cells.size() + row_heights.size());
+  }
+
+  /**
+   * Estimates the size of the .xml that append_rows() produces for
+   * the same arguments from the number, type and position of the
+   * cells and the lengths of their strings and formulas. The
+   * estimate is exact except for the length of numbers that are
+   * not integers below 10^15 in magnitude, which is taken to be
+   * 18 characters.
+   */
+  size_t Sheet::estimate_rows_size(const size_t first_block, const size_t end_block, const bool compact) const noexcept
+  {
+    const column_names_t &names = column_names();
+    size_t output = 0u;
+
+    for (size_t jBlock = first_block; jBlock < end_block; jBlock++)
+    {
+      const cell_block_t &block = cell_blocks[jBlock];
+
+      for (size_t row_pos = 0u; row_pos < block.rows.size(); row_pos++)
+      {
+        const size_t row_digits = decimal_digits(block.rows[row_pos]);
+        output += 16u + row_digits;
+
+        const size_t row_end = (row_pos + 1u < block.rows.size()) ? block.row_starts[row_pos + 1u] : block.cols.size();
+        uint32_t prev_col = 0u;
+        for (size_t cell_pos = block.row_starts[row_pos]; cell_pos < row_end; cell_pos++)
+        {
+          const uint32_t col = block.cols[cell_pos];
+          output += 2u;
+          if (!compact || col != prev_col + 1u)
+          {
+            output += 5u + names.lengths[col] + row_digits;
+          }
+          if (!compact || block.style_indices[cell_pos] != 0u)
+          {
+            output += 5u + decimal_digits(block.style_indices[cell_pos]);
+          }
+
+          const cell_value_t &value = block.values[cell_pos];
+          switch (block.types[cell_pos])
+          {
+            case CellType::NUMBER:
+              if (std::fabs(value.num_val) < 1.0e15 && value.num_val == std::trunc(value.num_val))
+              {
+                output += 12u + (std::signbit(value.num_val) ? 1u : 0u) + decimal_digits(static_cast<uint64_t>(std::fabs(value.num_val)));
+              }
+              else
+              {
+                output += 30u;
+              }
+              break;
+            case CellType::FORMULA:
+              output += 12u + value.formula.length;
+              break;
+            case CellType::STRING:
+              if (shared_columns[col])
+              {
+                output += 18u + decimal_digits(workbook.shared_string_positions[value.text_index]);
+              }
+              else
+              {
+                output += 35u + workbook.string_pool[value.text_index].size();
+              }
+              break;
+            default:
+              output += 2u;
+              break;
+          }
+          prev_col = col;
+        }
+      }
+    }
+
+    return output;
+  }
+
+  /**
+   * Appends the part of this Sheet's xml file that precedes the
+   * first row to file.
+   */
+  void Sheet::append_file_start(OutputBuffer &file) const noexcept(false)
+  {
+    append_worksheet_start(file);
+    
+    file.append(u8"<cols>");
+    for (std::pmr::set<uint32_t>::const_iterator used_col_itr = used_columns.cbegin();
+         used_col_itr != used_columns.cend();
+         used_col_itr++)
+    {
+      std::string colnum = std::to_string(*used_col_itr);
+      std::pair<uint32_t, double> cold_widths_key = std::make_pair(*used_col_itr, 0.0);
+      std::pmr::set<std::pair<uint32_t, double>, column_widths_sort_compare>::iterator col_widths_itr = column_widths.find(cold_widths_key);
+      if (col_widths_itr != column_widths.end())
+      {
+        file.append(u8"<col min=\"");
+        file.append(colnum);
+        file.append(u8"\" max=\"");
+        file.append(colnum);
+        file.append(u8"\" width=\"");
+        file.append(std::to_string(col_widths_itr->second));
+        file.append(u8"\" customWidth=\"1\"/>");
+      }
+      else
+      {
+        file.append(u8"<col min=\"");
+        file.append(colnum);
+        file.append(u8"\" max=\"");
+        file.append(colnum);
+        file.append(u8"\" width=\"9.005\" bestFit=\"1\"/>");
+      }
+    }
+    file.append(u8"</cols>");
+
+    if (cell_blocks.empty())
+    {
+      file.append(u8"<sheetData/>");
+    }
+    else
+    {
+      file.append(u8"<sheetData>");
+    }
+  }
+
+  /**
+   * Appends the rows held in cell_blocks[first_block] up to but
+   * not including cell_blocks[end_block] to file. Separate block
+   * ranges may be appended concurrently to separate buffers.
+   * compact is passed on to put_cell_start(). If archive is not
+   * null, file is passed on to its open file and emptied after
+   * every row that takes it to STREAM_BUFFER_SIZE bytes.
+   */
+  void Sheet::append_rows(OutputBuffer &file, const size_t first_block, const size_t end_block, const bool compact, IttyZip::IttyZip *archive) const noexcept(false)
+  {
+    for (size_t jBlock = first_block; jBlock < end_block; jBlock++)
+    {
+      const cell_block_t &block = cell_blocks[jBlock];
+
+      for (size_t row_pos = 0u; row_pos < block.rows.size(); row_pos++)
+      {
+        const uint32_t this_row = block.rows[row_pos];
+        append_row_start(file, this_row, row_heights);
+
+        const size_t row_end = (row_pos + 1u < block.rows.size()) ? block.row_starts[row_pos + 1u] : block.cols.size();
+        uint32_t prev_col = 0u;
+        for (size_t cell_pos = block.row_starts[row_pos]; cell_pos < row_end; cell_pos++)
+        {
+          const CellType type = block.types[cell_pos];
+          const cell_value_t &value = block.values[cell_pos];
+          if (type == CellType::STRING)
+          {
+            if (shared_columns[block.cols[cell_pos]])
+            {
+              append_shared_string_cell(file, this_row, block.cols[cell_pos], prev_col, compact, block.style_indices[cell_pos], workbook.shared_string_positions[value.text_index]);
+            }
+            else
+            {
+              append_cell(file, this_row, block.cols[cell_pos], prev_col, compact, type, block.style_indices[cell_pos], 0.0, workbook.string_pool[value.text_index]);
+            }
+          }
+          else if (type == CellType::FORMULA)
+          {
+            append_cell(file, this_row, block.cols[cell_pos], prev_col, compact, type, block.style_indices[cell_pos], 0.0, std::string_view(formula_text.data() + value.formula.offset, value.formula.length));
+          }
+          else
+          {
+            append_cell(file, this_row, block.cols[cell_pos], prev_col, compact, type, block.style_indices[cell_pos], value.num_val, std::string_view());
+          }
+          prev_col = block.cols[cell_pos];
+        }
+
+        file.append(u8"</row>");
+
+        if (archive != nullptr && file.size() >= STREAM_BUFFER_SIZE)
+        {
+          archive->writeFileData(file.data(), file.size());
+          file.clear();
+        }
+      }
+    }
+  }
+
+  /**
+   * Appends the part of this Sheet's xml file that follows the
+   * last row to file.
+   */
+  void Sheet::append_file_end(OutputBuffer &file) const noexcept(false)
+  {
+    if (!cell_blocks.empty())
+    {
+      file.append(u8"</sheetData>");
+    }
+
+    append_worksheet_end(file, merged_cells);
+  }
+
+  /**
+   * Splits cell_blocks into consecutive ranges of at least
+   * fragment_cells cells (except perhaps the last). Range k runs
+   * from cell_blocks[output[k]] up to cell_blocks[output[k+1]].
+   */
+  std::vector<size_t> Sheet::fragment_bounds(const size_t fragment_cells) const noexcept(false)
+  {
+    std::vector<size_t> output(1u, 0u);
+    size_t fragment_size = 0u;
+    for (size_t jBlock = 0u; jBlock < cell_blocks.size(); jBlock++)
+    {
+      fragment_size += cell_blocks[jBlock].cols.size();
+      if (fragment_size >= fragment_cells || jBlock + 1u == cell_blocks.size())
+      {
+        output.push_back(jBlock + 1u);
+        fragment_size = 0u;
+      }
+    }
+    return output;
+  }
+
+  /**
+   * The number of cells in this Sheet, including the empty
+   * cells that fill out merged cells.
+   */
+  size_t Sheet::cell_count(void) const noexcept
+  {
+    size_t output = 0u;
+    for (size_t jBlock = 0u; jBlock < cell_blocks.size(); jBlock++)
+    {
+      output += cell_blocks[jBlock].cols.size();
+    }
+    return output;
+  }
+
+  /**
+   * Gives the cell blocks and formula text of this Sheet back to
+   * the Workbook for reuse once its .xml file has been generated,
+   * and frees its string column counts.
+   */
+  void Sheet::release_cells(void) noexcept(false)
+  {
+    workbook.returnBlocks(cell_blocks);
+    if (formula_text.capacity() > 0u)
+    {
+      workbook.returnBuffer(formula_text);
+    }
+    string_columns.clear();
+    string_columns.shrink_to_fit();
+    shared_columns.clear();
+    shared_columns.shrink_to_fit();
+  }
+
+  /**
+   * Decides for each column with string cells whether it is
+   * written to the shared strings table (see
+   * Workbook::shareColumn()), adds the strings of the shared
+   * columns to the table and counts the decisions in the
+   * Workbook's string_stats. Must run before any of this Sheet's
+   * rows are appended; done by publish() one Sheet at a time.
+   */
+  void Sheet::share_strings(void) noexcept(false)
+  {
+    shared_columns.assign(string_columns.size(), false);
+    bool any_shared = false;
+
+    for (size_t jCol = 0u; jCol < string_columns.size(); jCol++)
+    {
+      const string_column_stats_t &column_stats = string_columns[jCol];
+      if (column_stats.cells == 0u)
+      {
+        continue;
+      }
+
+      if (workbook.shareColumn(column_stats))
+      {
+        shared_columns[jCol] = true;
+        any_shared = true;
+        workbook.string_stats.shared_columns++;
+        workbook.string_stats.shared_cells += column_stats.cells;
+      }
+      else
+      {
+        workbook.string_stats.inline_columns++;
+        workbook.string_stats.inline_cells += column_stats.cells;
+      }
+    }
+
+    if (!any_shared)
+    {
+      return;
+    }
+
+    for (size_t jBlock = 0u; jBlock < cell_blocks.size(); jBlock++)
+    {
+      const cell_block_t &block = cell_blocks[jBlock];
+      for (size_t cell_pos = 0u; cell_pos < block.cols.size(); cell_pos++)
+      {
+        if (block.types[cell_pos] == CellType::STRING && shared_columns[block.cols[cell_pos]])
+        {
+          workbook.shareString(block.values[cell_pos].text_index);
+        }
+      }
+    }
+  }
+
+  /**
+   * Add a cell with a numeric value to this StreamingSheet at the specified
+   * row & column. The cell must come after every cell already added.
+   */
+  void StreamingSheet::add_number_cell(const uint32_t row, const uint32_t col, const double number, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t integerref;
+    integerref.row = row;
+    integerref.col = col;
+    this->add_number_cell(integerref, number, cell_style);
+  }
+
+  /**
+   * Add a cell with a numeric value to this StreamingSheet at the specified
+   * row & column. The style is registered with the Workbook first;
+   * see Workbook::registerStyle().
+   */
+  void StreamingSheet::add_number_cell(const integerref_t &integerref, const double number, const cell_style_t &cell_style) noexcept(false)
+  {
+    this->add_number_cell(integerref, number, workbook.registerStyle(cell_style));
+  }
+
+  /**
+   * Add a cell with a numeric value and a registered style to this StreamingSheet at the specified
+   * row & column. The cell must come after every cell already added.
+   */
+  void StreamingSheet::add_number_cell(const integerref_t &integerref, const double number, const StyleId style) noexcept(false)
+  {
+    add_cell("add_number_cell()", integerref, CellType::NUMBER, style, number, std::string());
+  }
+
+  /**
+   * Add a cell with a numeric value and a registered style to this
+   * StreamingSheet at the specified row & column.
+   */
+  void StreamingSheet::add_number_cell(const uint32_t row, const uint32_t col, const double number, const StyleId style) noexcept(false)
+  {
+    integerref_t integerref;
+    integerref.row = row;
+    integerref.col = col;
+    this->add_number_cell(integerref, number, style);
+  }
+
+  /**
+   * Add a cell with a numeric value and a registered style to this
+   * StreamingSheet at the specified cell reference in mixedref format.
+   */
+  void StreamingSheet::add_number_cell(const std::string &mixedref, const double number, const StyleId style) noexcept(false)
+  {
+    integerref_t integerref = mixedref_to_integerref(mixedref);
+    this->add_number_cell(integerref, number, style);
+  }
+
+  /**
+   * Add a cell with a numeric value to this StreamingSheet at the specified
+   * cell reference in mixedref format.
+   */
+  void StreamingSheet::add_number_cell(const std::string &mixedref, const double number, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t integerref = mixedref_to_integerref(mixedref);
+    this->add_number_cell(integerref, number, cell_style);
+  }
+
+  /**
+   * Add a cell with a formula to this StreamingSheet at the specified
+   * row & column. The cell must come after every cell already added.
+   */
+  void StreamingSheet::add_formula_cell(const uint32_t row, const uint32_t col, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t integerref;
+    integerref.row = row;
+    integerref.col = col;
+    this->add_formula_cell(integerref, formula, cell_style);
+  }
+
+  /**
+   * Add a cell with a formula to this StreamingSheet at the specified
+   * row & column. The style is registered with the Workbook first;
+   * see Workbook::registerStyle().
+   */
+  void StreamingSheet::add_formula_cell(const integerref_t &integerref, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  {
+    this->add_formula_cell(integerref, formula, workbook.registerStyle(cell_style));
+  }
+
+  /**
+   * Add a cell with a formula and a registered style to this StreamingSheet at the specified
+   * row & column. The cell must come after every cell already added.
+   */
+  void StreamingSheet::add_formula_cell(const integerref_t &integerref, const std::string &formula, const StyleId style) noexcept(false)
+  {
+    if (formula.length() > MAX_FORMULA_LEN)
+    {
+      throw std::invalid_argument(std::string("the formula supplied to add_formula_cell() is too long."));
+    }
+
+    add_cell("add_formula_cell()", integerref, CellType::FORMULA, style, 0.0, formula);
+  }
+
+  /**
+   * Add a cell with a formula and a registered style to this
+   * StreamingSheet at the specified row & column.
+   */
+  void StreamingSheet::add_formula_cell(const uint32_t row, const uint32_t col, const std::string &formula, const StyleId style) noexcept(false)
+  {
+    integerref_t integerref;
+    integerref.row = row;
+    integerref.col = col;
+    this->add_formula_cell(integerref, formula, style);
+  }
+
+  /**
+   * Add a cell with a formula and a registered style to this
+   * StreamingSheet at the specified cell reference in mixedref format.
+   */
+  void StreamingSheet::add_formula_cell(const std::string &mixedref, const std::string &formula, const StyleId style) noexcept(false)
+  {
+    integerref_t integerref = mixedref_to_integerref(mixedref);
+    this->add_formula_cell(integerref, formula, style);
+  }
+
+  /**
+   * Add a cell with a formula to this StreamingSheet at the specified
+   * cell reference in mixedref format.
+   */
+  void StreamingSheet::add_formula_cell(const std::string &mixedref, const std::string &formula, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t integerref = mixedref_to_integerref(mixedref);
+    this->add_formula_cell(integerref, formula, cell_style);
+  }
+
+  /**
+   * Add a cell with a string value to this StreamingSheet at the specified
+   * row & column. The cell must come after every cell already added.
+   */
+  void StreamingSheet::add_string_cell(const uint32_t row, const uint32_t col, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t integerref;
+    integerref.row = row;
+    integerref.col = col;
+    this->add_string_cell(integerref, value, cell_style);
+  }
+
+  /**
+   * Add a cell with a string value to this StreamingSheet at the specified
+   * row & column. The style is registered with the Workbook first;
+   * see Workbook::registerStyle().
+   */
+  void StreamingSheet::add_string_cell(const integerref_t &integerref, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  {
+    this->add_string_cell(integerref, value, workbook.registerStyle(cell_style));
+  }
+
+  /**
+   * Add a cell with a string value and a registered style to this StreamingSheet at the specified
+   * row & column. The cell must come after every cell already added.
+   */
+  void StreamingSheet::add_string_cell(const integerref_t &integerref, const std::string &value, const StyleId style) noexcept(false)
+  {
+    check_string_value(value, "add_string_cell()");
+
+    add_cell("add_string_cell()", integerref, CellType::STRING, style, 0.0, value);
+  }
+
+  /**
+   * Add a cell with a string value and a registered style to this
+   * StreamingSheet at the specified row & column.
+   */
+  void StreamingSheet::add_string_cell(const uint32_t row, const uint32_t col, const std::string &value, const StyleId style) noexcept(false)
+  {
+    integerref_t integerref;
+    integerref.row = row;
+    integerref.col = col;
+    this->add_string_cell(integerref, value, style);
+  }
+
+  /**
+   * Add a cell with a string value and a registered style to this
+   * StreamingSheet at the specified cell reference in mixedref format.
+   */
+  void StreamingSheet::add_string_cell(const std::string &mixedref, const std::string &value, const StyleId style) noexcept(false)
+  {
+    integerref_t integerref = mixedref_to_integerref(mixedref);
+    this->add_string_cell(integerref, value, style);
+  }
+
+  /**
+   * Add a cell with a string value to this StreamingSheet at the specified
+   * cell reference in mixedref format.
+   */
+  void StreamingSheet::add_string_cell(const std::string &mixedref, const std::string &value, const cell_style_t &cell_style) noexcept(false)
+  {
+    integerref_t integerref = mixedref_to_integerref(mixedref);
+    this->add_string_cell(integerref, value, cell_style);
+  }
+
+  /**
+   * Merge the cells bounded by start_ref (upper left corner) and end_ref
+   * (lower right corner). Only the range is recorded; the value and style
+   * of the merged cell are those of the cell added at start_ref. Unlike
+   * Sheet, overlapping merged ranges are not detected.
+   */
+  void StreamingSheet::merge_cells(const integerref_t &start_ref, const integerref_t &end_ref) noexcept(false)
+  {
+    if (start_ref.col < 1u || 
+        start_ref.col > MAX_COL ||
+        start_ref.row < 1u ||
+        start_ref.row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string("merge_cells() received an invalid starting cell reference."));
+    }
+
+    if (end_ref.col < 1u || 
+        end_ref.col > MAX_COL ||
+        end_ref.row < 1u ||
+        end_ref.row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string("merge_cells() received an invalid ending cell reference."));
+    }
+
+    if (start_ref.col > end_ref.col || 
+        start_ref.row > end_ref.row ||
+        (start_ref.col == end_ref.col &&
+         start_ref.row == end_ref.row))
+    {
+      throw std::invalid_argument(std::string("merge_cells() received an ending cell reference equal or prior to its starting cell reference."));
+    }
+
+    if (finished)
+    {
+      throw std::runtime_error(std::string("merge_cells() called on a StreamingSheet that has already been written."));
+    }
+
+    merged_cell_t this_merge;
+    this_merge.start_ref = start_ref;
+    this_merge.end_ref = end_ref;
+    merged_cells.insert(std::move(this_merge));
+  }
+
+  /**
+   * Alternative option for merge_cells that accepts the cell references
+   * in mixedref format.
+   */
+  void StreamingSheet::merge_cells(const std::string &start_ref, const std::string &end_ref) noexcept(false)
+  {
+    integerref_t start_integerref = mixedref_to_integerref(start_ref);
+    integerref_t end_integerref = mixedref_to_integerref(end_ref);
+    this->merge_cells(start_integerref, end_integerref);
+  }
+
+  /**
+   * Set the width of the indicated column in characters.
+   * Must be called before the first cell is added to this StreamingSheet.
+   */
+  void StreamingSheet::set_column_width(const uint32_t col, const double width) noexcept(false)
+  {
+    if (width < MIN_COL_WIDTH || width > MAX_COL_WIDTH)
+    {
+      throw std::invalid_argument(std::string("set_column_width() received invalid width argument."));
+    }
+
+    if (col < 1u || col > MAX_COL)
+    {
+      throw std::invalid_argument(std::string("set_column_width() received invalid col argument."));
+    }
+
+    if (started)
+    {
+      throw std::runtime_error(std::string("set_column_width() called after cells were added to a StreamingSheet."));
+    }
+
+    column_widths.insert(std::make_pair(col, width));
+  }
+
+  /**
+   * Alternative option for set_column_width that accepts the column index
+   * in the format A, B, ..., Z, AA, AB, ...
+   */
+  void StreamingSheet::set_column_width(const std::string &column, const double width) noexcept(false)
+  {
+    uint32_t col = column_to_integer(column);
+    this->set_column_width(col, width);
+  }
+
+  /**
+   * Set the height of the indicated row in points.
+   * Must be called before the first cell of the row is added.
+   */
+  void StreamingSheet::set_row_height(const uint32_t row, const double height) noexcept(false)
+  {
+    if (height < MIN_ROW_HEIGHT || height > MAX_ROW_HEIGHT)
+    {
+      throw std::invalid_argument(std::string("set_row_height() received invalid height argument."));
+    }
+
+    if (row < 1u || row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string("set_row_height() received invalid row argument."));
+    }
+
+    if (finished || row <= last_row)
+    {
+      throw std::runtime_error(std::string("set_row_height() called for a row that a StreamingSheet has already written."));
+    }
+
+    row_heights.insert(std::make_pair(row, height));
+  }
+
+  /**
+   * Retrieve the name of this StreamingSheet; this is the name displayed
+   * on the sheet's tab in a popular office software suite.
+   */
+  std::string StreamingSheet::get_name(void) const noexcept
+  {
+    return name;
+  }
+
+  /**
+   * Private StreamingSheet constructor called by Workbook::addStreamingSheet().
+   */
+  StreamingSheet::StreamingSheet(const std::string &name_, const std::string &filename_, Workbook &workbook_) noexcept(false) :
+    workbook(workbook_), name(name_), filename(filename_), column_widths(workbook_.memory), row_heights(workbook_.memory), merged_cells(workbook_.memory),
+    string_columns(workbook_.memory), last_row(0u), last_col(0u), started(false), finished(false), write_buffer(workbook_.memory)
+  {
+    /* Nothing. */
+  }
+
+  /**
+   * Shared by the add_*_cell() methods: checks the cell reference and
+   * its order, then appends the cell's .xml to write_buffer, opening a
+   * new row as needed. caller names the public method for exception
+   * messages. num_val is used by NUMBER cells and text by FORMULA and
+   * STRING cells.
+   */
+  void StreamingSheet::add_cell(const char *caller, const integerref_t &integerref, const CellType type, const StyleId style, const double num_val, const std::string_view text) noexcept(false)
+  {
+    if (integerref.col < 1u || 
+        integerref.col > MAX_COL ||
+        integerref.row < 1u ||
+        integerref.row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string(caller) + " received an invalid cell reference.");
+    }
+
+    if (finished)
+    {
+      throw std::runtime_error(std::string(caller) + " called on a StreamingSheet that has already been written.");
+    }
+
+    if (integerref.row < last_row ||
+        (integerref.row == last_row && integerref.col <= last_col))
+    {
+      throw std::runtime_error(std::string(caller) + " received a cell out of order; StreamingSheet cells must be added row by row, left to right.");
+    }
+
+    uint16_t style_index = workbook.styleIndex(style, caller);
+
+    if (!started)
+    {
+      begin_file();
+    }
+
+    if (integerref.row != last_row)
+    {
+      if (last_row > 0u)
+      {
+        write_buffer.append(u8"</row>");
+      }
+      append_row_start(write_buffer, integerref.row, row_heights);
+      row_heights.erase(row_heights.begin(), row_heights.upper_bound(std::make_pair(integerref.row, MAX_ROW_HEIGHT)));
+    }
+
+    const uint32_t prev_col = (integerref.row == last_row ? last_col : 0u);
+    bool shared = false;
+    if (type == CellType::STRING && workbook.string_mode != StringMode::INLINE)
+    {
+      if (string_columns.size() <= integerref.col)
+      {
+        string_columns.resize(integerref.col + 1u);
+      }
+      string_column_stats_t &column_stats = string_columns[integerref.col];
+      uint32_t pool_index = workbook.internString(text, column_stats);
+      if (workbook.shareColumn(column_stats))
+      {
+        append_shared_string_cell(write_buffer, integerref.row, integerref.col, prev_col, workbook.compact_output, style_index, workbook.shareString(pool_index));
+        shared = true;
+      }
+    }
+
+    if (!shared)
+    {
+      append_cell(write_buffer, integerref.row, integerref.col, prev_col, workbook.compact_output, type, style_index, num_val, text);
+    }
+
+    if (type == CellType::STRING)
+    {
+      if (shared)
+      {
+        workbook.string_stats.shared_cells++;
+      }
+      else
+      {
+        workbook.string_stats.inline_cells++;
+      }
+    }
+    last_row = integerref.row;
+    last_col = integerref.col;
+
+    if (write_buffer.size() >= STREAM_BUFFER_SIZE)
+    {
+      flush();
+    }
+  }
+
+  /**
+   * Starts this StreamingSheet's file in the Workbook archive and
+   * writes everything that precedes the first row. Any other
+   * StreamingSheet still being written is completed first.
+   */
+  void StreamingSheet::begin_file(void) noexcept(false)
+  {
+    if (!workbook.opened)
+    {
+      throw std::runtime_error(std::string("StreamingSheet cells can only be written after Workbook::open()."));
+    }
+
+    if (workbook.streaming_sheet != nullptr)
+    {
+      workbook.streaming_sheet->end_file();
+    }
+
+    workbook.archive.beginFile(filename);
+    workbook.streaming_sheet = this;
+    started = true;
+
+    write_buffer = workbook.takeBuffer();
+    write_buffer.reserve(2u * STREAM_BUFFER_SIZE);
+    append_worksheet_start(write_buffer);
+    append_column_widths(write_buffer, column_widths);
+    write_buffer.append(u8"<sheetData>");
+  }
+
+  /**
+   * Passes write_buffer on to the open file in the Workbook archive.
+   */
+  void StreamingSheet::flush(void) noexcept(false)
+  {
+    workbook.archive.writeFileData(write_buffer.data(), write_buffer.size());
+    write_buffer.clear();
+  }
+
+  /**
+   * Writes everything that follows the last row and completes this
+   * StreamingSheet's file in the Workbook archive. A StreamingSheet
+   * that never received a cell is written out as an empty sheet.
+   */
+  void StreamingSheet::end_file(void) noexcept(false)
+  {
+    if (!started)
+    {
+      begin_file();
+    }
+
+    if (last_row > 0u)
+    {
+      write_buffer.append(u8"</row>");
+    }
+    write_buffer.append(u8"</sheetData>");
+    append_worksheet_end(write_buffer, merged_cells);
+    flush();
+    workbook.archive.endFile();
+
+    finished = true;
+    workbook.streaming_sheet = nullptr;
+    workbook.returnBuffer(write_buffer);
+    row_heights.clear();
+    string_columns.clear();
+    string_columns.shrink_to_fit();
+  }
+
+  /**
+   * Add a cell with a number value to this row at the specified
+   * column. The cell must come after every cell already added to
+   * the row.
+   */
+  void SheetRow::add_number_cell(const uint32_t col, const double number, const StyleId style) noexcept(false)
+  {
+    add_cell("add_number_cell()", col, CellType::NUMBER, style, number, std::string());
+  }
+
+  /**
+   * Add a cell with a formula to this row at the specified column.
+   * The cell must come after every cell already added to the row.
+   */
+  void SheetRow::add_formula_cell(const uint32_t col, const std::string &formula, const StyleId style) noexcept(false)
+  {
+    if (formula.length() > MAX_FORMULA_LEN)
+    {
+      throw std::invalid_argument(std::string("the formula supplied to add_formula_cell() is too long."));
+    }
+
+    add_cell("add_formula_cell()", col, CellType::FORMULA, style, 0.0, formula);
+  }
+
+  /**
+   * Add a cell with a string value to this row at the specified
+   * column. The cell must come after every cell already added to
+   * the row.
+   */
+  void SheetRow::add_string_cell(const uint32_t col, const std::string &value, const StyleId style) noexcept(false)
+  {
+    check_string_value(value, "add_string_cell()");
+
+    add_cell("add_string_cell()", col, CellType::STRING, style, 0.0, value);
+  }
+
+  /**
+   * Retrieve the number of the row being generated.
+   */
+  uint32_t SheetRow::get_row(void) const noexcept
+  {
+    return row;
+  }
+
+  /**
+   * Private SheetRow constructor called by GeneratedSheet::write_file().
+   */
+  SheetRow::SheetRow(GeneratedSheet &sheet_, OutputBuffer &buffer_, const uint32_t row_) noexcept :
+    sheet(sheet_), buffer(buffer_), row(row_), last_col(0u), string_cells(0u)
+  {
+    /* Nothing. */
+  }
+
+  /**
+   * Shared by the add_*_cell() methods: checks the column and its
+   * order, then appends the cell's .xml to buffer, opening the row
+   * with the first cell. caller names the public method for
+   * exception messages.
+   */
+  void SheetRow::add_cell(const char *caller, const uint32_t col, const CellType type, const StyleId style, const double num_val, const std::string_view text) noexcept(false)
+  {
+    if (col < 1u || col > MAX_COL)
+    {
+      throw std::invalid_argument(std::string(caller) + " received an invalid column.");
+    }
+
+    if (col <= last_col)
+    {
+      throw std::runtime_error(std::string(caller) + " received a cell out of order; the cells of a generated row must be added left to right.");
+    }
+
+    uint16_t style_index = sheet.workbook.styleIndex(style, caller);
+
+    if (last_col == 0u)
+    {
+      append_row_start(buffer, row, sheet.row_heights);
+    }
+
+    append_cell(buffer, row, col, last_col, sheet.workbook.compact_output, type, style_index, num_val, text);
+
+    if (type == CellType::STRING)
+    {
+      string_cells++;
+    }
+    last_col = col;
+  }
+
+  /**
+   * Set the width of the indicated column in characters.
+   */
+  void GeneratedSheet::set_column_width(const uint32_t col, const double width) noexcept(false)
+  {
+    if (width < MIN_COL_WIDTH || width > MAX_COL_WIDTH)
+    {
+      throw std::invalid_argument(std::string("set_column_width() received invalid width argument."));
+    }
+
+    if (col < 1u || col > MAX_COL)
+    {
+      throw std::invalid_argument(std::string("set_column_width() received invalid col argument."));
+    }
+
+    column_widths.insert(std::make_pair(col, width));
+  }
+
+  /**
+   * Alternative option for set_column_width that accepts the column index
+   * in the format A, B, ..., Z, AA, AB, ...
+   */
+  void GeneratedSheet::set_column_width(const std::string &column, const double width) noexcept(false)
+  {
+    uint32_t col = column_to_integer(column);
+    this->set_column_width(col, width);
+  }
+
+  /**
+   * Set the height of the indicated row in points.
+   */
+  void GeneratedSheet::set_row_height(const uint32_t row, const double height) noexcept(false)
+  {
+    if (height < MIN_ROW_HEIGHT || height > MAX_ROW_HEIGHT)
+    {
+      throw std::invalid_argument(std::string("set_row_height() received invalid height argument."));
+    }
+
+    if (row < 1u || row > MAX_ROW)
+    {
+      throw std::invalid_argument(std::string("set_row_height() received invalid row argument."));
+    }
+
+    row_heights.insert(std::make_pair(row, height));
+  }
+
+  /**
+   * Retrieve the name of this GeneratedSheet; this is the name displayed
+   * on the sheet's tab in a popular office software suite.
+   */
+  std::string GeneratedSheet::get_name(void) const noexcept
+  {
+    return name;
+  }
+
+  /**
+   * Private GeneratedSheet constructor called by Workbook::addGeneratedSheet().
+   */
+  GeneratedSheet::GeneratedSheet(const std::string &name_, const std::string &filename_, const row_generator_t &generator_, Workbook &workbook_) noexcept(false) :
+    workbook(workbook_), name(name_), filename(filename_), generator(generator_), column_widths(workbook_.memory), row_heights(workbook_.memory)
+  {
+    /* Nothing. */
+  }
+
+  /**
+   * Writes this GeneratedSheet's file to the Workbook archive,
+   * pulling rows from generator until it returns false or MAX_ROW
+   * has been written. The .xml is passed on to the archive about
+   * every STREAM_BUFFER_SIZE bytes, so only the row being
+   * generated is ever held in memory.
+   */
+  void GeneratedSheet::write_file(void) noexcept(false)
+  {
+    OutputBuffer buffer = workbook.takeBuffer();
+    buffer.reserve(2u * STREAM_BUFFER_SIZE);
+    append_worksheet_start(buffer);
+    append_column_widths(buffer, column_widths);
+    buffer.append(u8"<sheetData>");
+    workbook.archive.beginFile(filename);
+
+    for (uint32_t row = 1u; row <= MAX_ROW; row++)
+    {
+      const size_t row_start = buffer.size();
+      SheetRow cells(*this, buffer, row);
+      if (!generator(row, cells))
+      {
+        buffer.truncate(row_start);
+        break;
+      }
+
+      if (cells.last_col > 0u)
+      {
+        buffer.append(u8"</row>");
+        workbook.string_stats.inline_cells += cells.string_cells;
+      }
+
+      if (buffer.size() >= STREAM_BUFFER_SIZE)
+      {
+        workbook.archive.writeFileData(buffer.data(), buffer.size());
+        buffer.clear();
+      }
+    }
+
+    buffer.append(u8"</sheetData>");
+    append_worksheet_end(buffer, std::pmr::set<merged_cell_t, merged_cell_sort_compare>(workbook.memory));
+    workbook.archive.writeFileData(buffer.data(), buffer.size());
+    workbook.archive.endFile();
+    workbook.returnBuffer(buffer);
+  }
+
+  /**
+   * Workbook basic constructor; memory comes from the default
+   * memory resource.
+   */
+  Workbook::Workbook(void) noexcept : Workbook(std::pmr::get_default_resource())
+  {
+    default_thread_count = 0u;
+    thread_count = default_thread_count;
+  }
+
+  /**
+   * Workbook constructor that takes all of the Workbook's memory,
+   * and that of its sheets, from memory_, e.g. a
+   * std::pmr::monotonic_buffer_resource or an application's own
+   * pool. memory_ must outlive the Workbook.
+   *
+   * Most memory resources are not thread-safe, so such a Workbook
+   * publishes on the calling thread only. If memory_ is safe to
+   * use from several threads at once, as
+   * std::pmr::synchronized_pool_resource is, call setThreadCount()
+   * to let publish() use more threads; the setting goes back to 1
+   * on reset().
+   */
+  Workbook::Workbook(std::pmr::memory_resource *memory_) noexcept : owned_memory(), memory(memory_), sheet_infos(memory_), sheets(memory_), streaming_sheets(memory_), generated_sheets(memory_),
+    streaming_sheet(nullptr), opened(false), thread_count(1u), default_thread_count(1u), compact_output(false), string_mode(StringMode::INLINE), shared_string_threshold(DEFAULT_SHARED_STRING_THRESHOLD),
+    string_text(memory_), string_indices(memory_), string_pool(memory_), shared_strings(memory_), shared_string_positions(memory_), string_stats(), published_string_stats(),
+    cell_styles(memory_), style_indices(memory_), last_style_key(NO_STYLE_KEY), last_style_index(0u), spare_buffers(memory_), spare_blocks(memory_)
+  {
+    /**
+     * Add the generic style first so it becomes the default
+     * cell style.
+     */
+    this->addStyle(BasicWorkbook::generic_style);
+  }
+
+  /**
+   * Returns this Workbook to the state of a newly constructed one,
+   * without the cost of constructing one: all sheets, strings and
+   * styles are discarded and every setting goes back to its
+   * default, but cell blocks, text arenas, output buffers, the
+   * style and string tables and the archive's central directory
+   * keep the memory they have grown into, ready for the next
+   * workbook. StyleIds registered before reset() must not be used
+   * afterwards. A file opened by open() and not yet published is
+   * closed, incomplete.
+   */
+  void Workbook::reset(void) noexcept(false)
+  {
+    if (opened)
+    {
+      archive.discard();
+      opened = false;
+    }
+    streaming_sheet = nullptr;
+
+    for (size_t jSheet = 0u; jSheet < sheets.size(); jSheet++)
+    {
+      sheets.at(jSheet).release_cells();
+    }
+    for (std::pmr::deque<StreamingSheet>::iterator streaming_itr = streaming_sheets.begin();
+         streaming_itr != streaming_sheets.end();
+         streaming_itr++)
+    {
+      if (streaming_itr->write_buffer.capacity() > 0u)
+      {
+        returnBuffer(streaming_itr->write_buffer);
+      }
+    }
+    sheets.clear();
+    streaming_sheets.clear();
+    generated_sheets.clear();
+    sheet_infos.clear();
+    clearStrings();
+    string_stats = string_stats_t();
+    published_string_stats = string_stats_t();
+
+    cell_styles.clear();
+    style_indices.clear();
+    last_style_key = NO_STYLE_KEY;
+    last_style_index = 0u;
+    this->addStyle(BasicWorkbook::generic_style);
+
+    thread_count = default_thread_count;
+    compact_output = false;
+    string_mode = StringMode::INLINE;
+    shared_string_threshold = DEFAULT_SHARED_STRING_THRESHOLD;
+  }
+
+  /**
+   * Adds a new blank Sheet to this Workbook and returns a 
+   * reference to it. The reference is meant to be used by
+   * the caller to add cells to the Sheet.
+   *
+   * name is the name of the Sheet that appears in the tab
+   * that is used to view the sheet in a popular office software
+   * suite.
+   */
+  Sheet& Workbook::addSheet(const std::string &name) noexcept(false)
+  {
+    sheet_info_t sheet_info = nextSheetInfo(name);
+    sheets.push_back(std::move(Sheet(sheet_info.name, sheet_info.filename, sheet_info.sheetId, sheet_info.relId, *this)));
+    sheet_infos.push_back(std::move(sheet_info));
+    return sheets.back();
+  }
+
+  /**
+   * Adds a new StreamingSheet to this Workbook and returns a
+   * reference to it, which stays valid until publish(). Cells
+   * added to the StreamingSheet are written straight to the
+   * output file, so open() must be called first.
+   *
+   * name is the name of the sheet that appears in the tab
+   * that is used to view the sheet in a popular office software
+   * suite.
+   */
+  StreamingSheet& Workbook::addStreamingSheet(const std::string &name) noexcept(false)
+  {
+    if (!opened)
+    {
+      throw std::runtime_error(std::string("addStreamingSheet() called before open()."));
+    }
+    sheet_info_t sheet_info = nextSheetInfo(name);
+    streaming_sheets.push_back(StreamingSheet(sheet_info.name, sheet_info.filename, *this));
+    sheet_infos.push_back(std::move(sheet_info));
+    return streaming_sheets.back();
+  }
+
+  /**
+   * Adds a new GeneratedSheet to this Workbook and returns a
+   * reference to it, which stays valid until publish(). The
+   * GeneratedSheet stores no cells; publish() calls generator for
+   * its rows, in order, while writing the sheet to the output file.
+   *
+   * name is the name of the sheet that appears in the tab
+   * that is used to view the sheet in a popular office software
+   * suite.
+   */
+  GeneratedSheet& Workbook::addGeneratedSheet(const std::string &name, const row_generator_t &generator) noexcept(false)
+  {
+    if (!generator)
+    {
+      throw std::invalid_argument(std::string("addGeneratedSheet() received an empty row generator."));
+    }
+    sheet_info_t sheet_info = nextSheetInfo(name);
+    generated_sheets.push_back(GeneratedSheet(sheet_info.name, sheet_info.filename, generator, *this));
+    sheet_infos.push_back(std::move(sheet_info));
+    return generated_sheets.back();
+  }
+
+  /**
+   * Sets the number of threads publish() uses to generate Sheet
+   * .xml files. 0 means one thread per hardware thread and 1
+   * generates every Sheet on the calling thread. A Workbook
+   * constructed with its own memory resource uses 1 until this is
+   * called; any other value requires that resource to be
+   * thread-safe.
+   */
+  void Workbook::setThreadCount(const unsigned int count) noexcept
+  {
+    thread_count = count;
+  }
+
+  /**
+   * Selects compact Sheet .xml output, which leaves out the cell
+   * reference of each cell that directly follows the previous cell
+   * in its row and the style of each cell with the default style.
+   * The workbook contents are unchanged; the files are smaller and
+   * faster to write. Off by default. Affects Sheets published and
+   * StreamingSheet cells added after the call.
+   */
+  void Workbook::setCompactOutput(const bool compact) noexcept
+  {
+    compact_output = compact;
+  }
+
+  /**
+   * Selects how the text of string cells is written: inline in
+   * each cell, or once per distinct string in a shared strings
+   * table that cells refer to by index. The string pool is kept
+   * either way, so each distinct string is held in memory only
+   * once. Affects Sheets published and StreamingSheet cells added
+   * after the call. StringMode::INLINE by default.
+   */
+  void Workbook::setStringMode(const StringMode mode) noexcept
+  {
+    string_mode = mode;
+  }
+
+  /**
+   * Sets the share of repeated values, from 0 to 1, at or above
+   * which a column is written to the shared strings table in
+   * StringMode::ADAPTIVE. A value is repeated if an earlier string
+   * cell anywhere in the Workbook already held it. Sheet columns
+   * are judged on all of their cells at publish(); StreamingSheet
+   * columns on the cells added so far, cell by cell.
+   * DEFAULT_SHARED_STRING_THRESHOLD by default.
+   */
+  void Workbook::setSharedStringThreshold(const double threshold) noexcept(false)
+  {
+    if (!(threshold >= 0.0 && threshold <= 1.0))
+    {
+      throw std::invalid_argument(std::string("setSharedStringThreshold() received a threshold outside [0, 1]."));
+    }
+    shared_string_threshold = threshold;
+  }
+
+  /**
+   * Returns how the string cells of the last published Workbook
+   * were written: the number of cells and Sheet columns written
+   * inline and to the shared strings table, and the number of
+   * distinct strings in that table.
+   */
+  string_stats_t Workbook::getStringStats(void) const noexcept
+  {
+    return published_string_stats;
+  }
+
+  /**
+   * Generates the .xml file of every Sheet and adds it to the
+   * archive. Purely a subroutine of publish().
+   *
+   * With one thread, each Sheet is written straight into the
+   * archive in chunks (see Sheet::write_file()). With more than
+   * one thread, Sheets with at least twice
+   * SHEET_FRAGMENT_CELLS cells are written first, one at a time,
+   * each split into row range fragments that are generated in
+   * parallel (see writeSheetFragments()). The remaining Sheets are
+   * then generated in parallel, one per worker, and added to the
+   * archive in whatever order they finish.
+   */
+  void Workbook::writeSheets(void) noexcept(false)
   {
-    if (width < MIN_COL_WIDTH || width > MAX_COL_WIDTH)
+    size_t num_threads = (thread_count > 0u ? thread_count : std::thread::hardware_concurrency());
+
+    if (num_threads <= 1u)
     {
-      throw std::invalid_argument(std::string("set_column_width() received invalid width argument."));
+      OutputBuffer chunk = takeBuffer();
+      while (!sheets.empty())
+      {
+        sheets.back().write_file(chunk, compact_output);
+        sheets.back().release_cells();
+        sheets.pop_back();
+      }
+      returnBuffer(chunk);
+      return;
     }
 
-    if (col < 1u || col > MAX_COL)
+    std::vector<size_t> small_sheets;
+    for (size_t jSheet = 0u; jSheet < sheets.size(); jSheet++)
     {
-      throw std::invalid_argument(std::string("set_column_width() received invalid col argument."));
+      if (sheets.at(jSheet).cell_count() >= 2u * SHEET_FRAGMENT_CELLS)
+      {
+        writeSheetFragments(sheets.at(jSheet), num_threads);
+      }
+      else
+      {
+        small_sheets.push_back(jSheet);
+      }
     }
 
-    column_widths.insert(std::make_pair(col, width));
+    generate_parallel(small_sheets.size(), std::min(num_threads, small_sheets.size()),
+      [&](const size_t index)
+      {
+        Sheet &sheet = sheets.at(small_sheets.at(index));
+        OutputBuffer file = takeBuffer();
+        sheet.generate_file(file, compact_output);
+        sheet.release_cells();
+        return file;
+      },
+      [&](const size_t index, OutputBuffer &file)
+      {
+        archive.addFile(sheets.at(small_sheets.at(index)).filename, file.data(), file.size());
+        returnBuffer(file);
+      },
+      false);
+    sheets.clear();
   }
 
   /**
-   * Alternative option for set_column_width that accepts the column index
-   * in the format A, B, ..., Z, AA, AB, ...
+   * Writes the .xml file of a large Sheet as a sequence of row
+   * range fragments, each of about SHEET_FRAGMENT_CELLS cells.
+   * Fragments are generated on num_threads threads and streamed
+   * into the archive in order, so only a few fragments are held
+   * in memory at once. Purely a subroutine of writeSheets().
    */
-  void Sheet::set_column_width(const std::string &column, const double width) noexcept(false)
+  void Workbook::writeSheetFragments(Sheet &sheet, const size_t num_threads) noexcept(false)
   {
-    uint32_t col = column_to_integer(column);
-    this->set_column_width(col, width);
+    std::vector<size_t> bounds = sheet.fragment_bounds(SHEET_FRAGMENT_CELLS);
+
+    archive.beginFile(sheet.filename);
+    OutputBuffer file_part = takeBuffer();
+    sheet.append_file_start(file_part);
+    archive.writeFileData(file_part.data(), file_part.size());
+
+    generate_parallel(bounds.size() - 1u, num_threads,
+      [&](const size_t index)
+      {
+        OutputBuffer fragment = takeBuffer();
+        fragment.reserve(sheet.estimate_rows_size(bounds.at(index), bounds.at(index + 1u), compact_output));
+        sheet.append_rows(fragment, bounds.at(index), bounds.at(index + 1u), compact_output);
+        return fragment;
+      },
+      [&](const size_t, OutputBuffer &fragment)
+      {
+        archive.writeFileData(fragment.data(), fragment.size());
+        returnBuffer(fragment);
+      },
+      true);
+
+    file_part.clear();
+    sheet.append_file_end(file_part);
+    archive.writeFileData(file_part.data(), file_part.size());
+    archive.endFile();
+    returnBuffer(file_part);
+    sheet.release_cells();
   }
 
   /**
-   * Set the heights of the indicated row in points.
-   *
-   * This value is only actually applied to columns that have at least one
-   * non-empty cell.
+   * Writes the shared string pool to xl/sharedStrings.xml,
+   * passing it to the archive in pieces of about
+   * STREAM_BUFFER_SIZE bytes. Purely a subroutine of publish().
    */
-  void Sheet::set_row_height(const uint32_t row, const double height) noexcept(false)
+  void Workbook::writeSharedStrings(void) noexcept(false)
   {
-    if (height < MIN_ROW_HEIGHT || height > MAX_ROW_HEIGHT)
-    {
-      throw std::invalid_argument(std::string("set_row_height() received invalid height argument."));
-    }
+    archive.beginFile("xl/sharedStrings.xml");
 
-    if (row < 1u || row > MAX_ROW)
+    OutputBuffer buffer = takeBuffer();
+    buffer.append(u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>");
+    buffer.append(u8"<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" uniqueCount=\"");
+    buffer.append(std::to_string(shared_strings.size()));
+    buffer.append(u8"\">");
+
+    for (size_t jString = 0u; jString < shared_strings.size(); jString++)
     {
-      throw std::invalid_argument(std::string("set_row_height() received invalid row argument."));
+      buffer.append(u8"<si><t>");
+      buffer.append(string_pool[shared_strings[jString]]);
+      buffer.append(u8"</t></si>");
+
+      if (buffer.size() >= STREAM_BUFFER_SIZE)
+      {
+        archive.writeFileData(buffer.data(), buffer.size());
+        buffer.clear();
+      }
     }
 
-    row_heights.insert(std::make_pair(row, height));
+    buffer.append(u8"</sst>");
+    archive.writeFileData(buffer.data(), buffer.size());
+    archive.endFile();
+    returnBuffer(buffer);
   }
 
   /**
-   * Retrieve the name of this Sheet; this is the name displayed
-   * on the Sheet's tab in a popular office software suite.
+   * Returns an empty OutputBuffer, reusing the storage of one
+   * given back through returnBuffer() if there is one. May be
+   * called from any thread.
    */
-  std::string Sheet::get_name(void) const noexcept
+  OutputBuffer Workbook::takeBuffer(void) noexcept(false)
   {
-    return name;
+    std::lock_guard<std::mutex> spare_lock(spare_buffers_mutex);
+    if (spare_buffers.empty())
+    {
+      return OutputBuffer(memory);
+    }
+    OutputBuffer buffer = std::move(spare_buffers.back());
+    spare_buffers.pop_back();
+    return buffer;
   }
 
   /**
-   * Private Sheet constructor called by Workbook::addSheet().
-   * The thought is that the user of this program shouldn't have to manage
-   * filenames, sheetIds, and relIds within the workbook. They still get to
-   * name the Sheet, since name is displayed on the Sheet's tab in a
-   * popular office software suite.
+   * Takes over buffer, which is left without storage, and keeps
+   * its capacity for later takeBuffer() calls. May be called from
+   * any thread.
    */
-  Sheet::Sheet(const std::string &name_, const std::string &filename_, const uint32_t sheetId_, const std::string &relId_, Workbook &workbook_) noexcept(false) :
-    workbook(workbook_), name(name_), filename(filename_), sheetId(sheetId_), relId(relId_)
+  void Workbook::returnBuffer(OutputBuffer &buffer) noexcept(false)
   {
-    /* Nothing. */
+    buffer.clear();
+    std::lock_guard<std::mutex> spare_lock(spare_buffers_mutex);
+    spare_buffers.push_back(std::move(buffer));
   }
 
   /**
-   * Adds an empty cell to the sheet. Used for all cell references except
-   * the upper left reference in a merged cell.
+   * Returns a cell block with no cells, reusing the arrays of one
+   * given back through returnBlocks() if there is one. May be
+   * called from any thread.
    */
-  void Sheet::add_empty_cell(const integerref_t &integerref, const cell_style_t &cell_style) noexcept(false)
+  cell_block_t Workbook::takeBlock(void) noexcept(false)
   {
-    if (integerref.col < 1u || 
-        integerref.col > MAX_COL ||
-        integerref.row < 1u ||
-        integerref.row > MAX_ROW)
+    std::lock_guard<std::mutex> spare_lock(spare_blocks_mutex);
+    if (spare_blocks.empty())
     {
-      throw std::invalid_argument(std::string("add_empty_cell() received an invalid cell reference."));
+      return empty_block(memory);
     }
+    cell_block_t block = std::move(spare_blocks.back());
+    spare_blocks.pop_back();
+    return block;
+  }
 
-    cell_t cell = {0};
-    cell.integerref = integerref;
-    cell.type = CellType::EMPTY;
-    cell.style_index = workbook.addStyle(cell_style);
-    cell.str_fml_val = "";
-    cell.num_val = std::numeric_limits<double>::quiet_NaN();
-
-    std::pair<std::set<cell_t,cell_sort_compare>::iterator, bool> insret = cells.insert(std::move(cell));
-    if (!insret.second)
+  /**
+   * Takes over the cell blocks in blocks, which is left empty, and
+   * keeps their arrays, emptied, for later takeBlock() calls. May
+   * be called from any thread.
+   */
+  void Workbook::returnBlocks(std::pmr::vector<cell_block_t> &blocks) noexcept(false)
+  {
+    std::lock_guard<std::mutex> spare_lock(spare_blocks_mutex);
+    spare_blocks.reserve(spare_blocks.size() + blocks.size());
+    for (size_t jBlock = 0u; jBlock < blocks.size(); jBlock++)
     {
-      throw std::runtime_error(std::string("add_empty_cell() encountered duplicate insertion of a cell at the same reference."));
+      cell_block_t &block = blocks[jBlock];
+      block.rows.clear();
+      block.row_starts.clear();
+      block.cols.clear();
+      block.style_indices.clear();
+      block.types.clear();
+      block.values.clear();
+      spare_blocks.push_back(std::move(block));
     }
-    used_columns.insert(integerref.col);
+    blocks.clear();
   }
 
   /**
-   * Produces a string holding the contents of this Sheet's xml
-   * file inside the actual workbook ZIP archive.
+   * Checks name for a new sheet and assigns the new sheet its
+   * filename, sheetId and relId.
    */
-  std::string Sheet::generate_file(void) const noexcept
+  sheet_info_t Workbook::nextSheetInfo(const std::string &name) const noexcept(false)
   {
-    std::string file;
-    file += u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>";
-    file += u8"<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\">";
-    file += u8"<sheetViews><sheetView workbookViewId=\"0\"/></sheetViews>";
-    file += u8"<sheetFormatPr defaultRowHeight=\"17\"/>";
-    
-    file += u8"<cols>";
-    for (std::set<uint32_t>::const_iterator used_col_itr = used_columns.cbegin();
-         used_col_itr != used_columns.cend();
-         used_col_itr++)
+    if (name.empty())
     {
-      std::string colnum = std::to_string(*used_col_itr);
-      std::pair<uint32_t, double> cold_widths_key = std::make_pair(*used_col_itr, 0.0);
-      std::set<std::pair<uint32_t, double> >::iterator col_widths_itr = column_widths.find(cold_widths_key);
-      if (col_widths_itr != column_widths.end())
-      {
-        file += u8"<col min=\"" + colnum + "\" max=\"" + colnum + "\" width=\"" + std::to_string(col_widths_itr->second) + "\" customWidth=\"1\"/>";
-      }
-      else
+      throw std::invalid_argument(std::string("addsheet() received an empty name for a new sheet."));
+    }
+
+    for (size_t jSheet = 0u; jSheet < sheet_infos.size(); jSheet++)
+    {
+      if (case_insensitive_same(name, sheet_infos.at(jSheet).name))
       {
-        file += u8"<col min=\"" + colnum + "\" max=\"" + colnum + "\" width=\"9.005\" bestFit=\"1\"/>";
+        throw std::runtime_error(std::string("addSheet() received a new sheet with the same name as an existing sheet."));
       }
     }
-    file += u8"</cols>";
 
-    if (cells.empty())
+    sheet_info_t sheet_info;
+    sheet_info.name = name;
+    sheet_info.sheetId = static_cast<uint32_t>(sheet_infos.size() + 1u);
+    sheet_info.filename = "xl/worksheets/sheet" + std::to_string(sheet_info.sheetId) + ".xml";
+    sheet_info.relId = "rId" + std::to_string(sheet_info.sheetId + 1u);
+    return sheet_info;
+  }
+
+  /**
+   * Returns the position of value in the string pool, adding it
+   * first if it is not there yet, and counts the cell holding it
+   * in column_stats.
+   */
+  uint32_t Workbook::internString(const std::string_view value, string_column_stats_t &column_stats) noexcept(false)
+  {
+    column_stats.cells++;
+
+    std::pmr::unordered_map<std::string_view, uint32_t>::const_iterator found = string_indices.find(value);
+    if (found != string_indices.end())
     {
-      file += u8"<sheetData/>";
+      return found->second;
     }
-    else
-    {
-      file += u8"<sheetData>";
-      uint32_t this_row = 0u;
-
-      for (std::set<cell_t,cell_sort_compare>::const_iterator cell_itr = cells.cbegin();
-           cell_itr != cells.cend();
-           cell_itr++)
-      {
-        const cell_t &this_cell = *cell_itr;
-        
-        if (this_cell.integerref.row > this_row)
-        {
-          if (this_row > 0u)
-          {
-            file += u8"</row>";
-          }
-          this_row = this_cell.integerref.row;
-          file += u8"<row r=\"" + std::to_string(this_row) + "\"";
-          
-          std::pair<uint32_t, double> row_heights_key = std::make_pair(this_row, 0.0);
-          std::set<std::pair<uint32_t, double> >::iterator row_heights_itr = row_heights.find(row_heights_key);
-          if (row_heights_itr != row_heights.end())
-          {
-            file += " ht=\"" + std::to_string(row_heights_itr->second) + "\" customHeight=\"1\"";
-          }
 
-          file += u8">";
-        }
-        
-        std::string mixedref = integerref_to_mixedref(this_cell.integerref);
+    const uint32_t pool_index = static_cast<uint32_t>(string_pool.size());
+    const std::string_view stored = string_text.store(value);
+    string_pool.push_back(stored);
+    string_indices.emplace(stored, pool_index);
+    column_stats.new_values++;
+    return pool_index;
+  }
 
-        if (this_cell.type == CellType::NUMBER)
-        {
-          file += u8"<c r=\"" + mixedref + "\"";
-          file += u8" s=\"" + std::to_string(this_cell.style_index) + "\"";
-          file += u8"><v>" + std::to_string(this_cell.num_val) + "</v></c>";
-        }
-        else if (this_cell.type == CellType::FORMULA)
-        {
-          file += u8"<c r=\"" + mixedref + "\"";
-          file += u8" s=\"" + std::to_string(this_cell.style_index) + "\"";
-          file += u8"><f>" + this_cell.str_fml_val + "</f></c>";
-        }
-        else if (this_cell.type == CellType::STRING)
-        {
-          file += u8"<c r=\"" + mixedref + "\"";
-          file += u8" s=\"" + std::to_string(this_cell.style_index) + "\" ";
-          file += u8"t=\"inlineStr\"><is><t>" + this_cell.str_fml_val + "</t></is></c>";
-        }
-        else if (this_cell.type == CellType::EMPTY)
-        {
-          file += u8"<c r=\"" + mixedref + "\"";
-          file += u8" s=\"" + std::to_string(this_cell.style_index) + "\"/>";
-        }
-      }
-      file += u8"</row></sheetData>";
+  /**
+   * Returns the position in xl/sharedStrings.xml of the string at
+   * pool_index in the string pool, adding it to the end of the
+   * table first if it is not there yet.
+   */
+  uint32_t Workbook::shareString(const uint32_t pool_index) noexcept(false)
+  {
+    if (shared_string_positions.size() <= pool_index)
+    {
+      shared_string_positions.resize(string_pool.size(), NOT_SHARED);
     }
 
-    if (!merged_cells.empty())
+    uint32_t &position = shared_string_positions[pool_index];
+    if (position == NOT_SHARED)
     {
-      file += u8"<mergeCells count=\"" + std::to_string(merged_cells.size()) + "\">";
-      
-      for (std::set<merged_cell_t, merged_cell_sort_compare>::const_iterator merged_cell_itr = merged_cells.cbegin();
-           merged_cell_itr != merged_cells.cend();
-           merged_cell_itr++)
-      {
-        const merged_cell_t &this_merge = *merged_cell_itr;
-        std::string start_mixedref = integerref_to_mixedref(this_merge.start_ref);
-        std::string end_mixedref = integerref_to_mixedref(this_merge.end_ref);
+      position = static_cast<uint32_t>(shared_strings.size());
+      shared_strings.push_back(pool_index);
+    }
+    return position;
+  }
 
-        file += u8"<mergeCell ref=\"" + start_mixedref + ":" + end_mixedref + "\"/>";
-      }
-      
-      file += u8"</mergeCells>";
+  /**
+   * Decides whether a column with the string cell counts in
+   * column_stats is written to the shared strings table under
+   * the current string_mode and shared_string_threshold.
+   */
+  bool Workbook::shareColumn(const string_column_stats_t &column_stats) const noexcept
+  {
+    if (string_mode == StringMode::SHARED)
+    {
+      return true;
     }
-    
-    file += u8"</worksheet>";
-    return file;
+    if (string_mode == StringMode::ADAPTIVE && column_stats.cells > 0u)
+    {
+      const double repeated = static_cast<double>(column_stats.cells - column_stats.new_values);
+      return repeated >= shared_string_threshold * static_cast<double>(column_stats.cells);
+    }
+    return false;
   }
 
   /**
-   * Workbook basic constructor.
+   * Empties the string pool and the shared strings table, keeping
+   * their capacity for the next Workbook built.
    */
-  Workbook::Workbook(void) noexcept
+  void Workbook::clearStrings(void) noexcept
   {
-    /**
-     * Add the generic style first so it becomes the default
-     * cell style.
-     */
-    this->addStyle(BasicWorkbook::generic_style);
+    shared_string_positions.clear();
+    shared_strings.clear();
+    string_pool.clear();
+    string_indices.clear();
+    string_text.clear();
   }
 
   /**
-   * Adds a new blank Sheet to this Workbook and returns a 
-   * reference to it. The reference is meant to be used by
-   * the caller to add cells to the Sheet.
+   * If a style is already stored, this just returns the index of the style.
+   * Otherwise, it stores the style and then returns the index.
    *
-   * name is the name of the Sheet that appears in the tab
-   * that is used to view the sheet in a popular office software
-   * suite.
+   * Styles are found by their packed style_key() in style_indices.
+   * Consecutive cells usually share a style, so the last style
+   * looked up is checked before the hash map.
    */
-  Sheet& Workbook::addSheet(const std::string &name) noexcept(false)
+  size_t Workbook::addStyle(const cell_style_t &cell_style) noexcept
   {
-    if (name.empty())
+    const uint32_t key = style_key(cell_style);
+    if (key == last_style_key)
     {
-      throw std::invalid_argument(std::string("addsheet() received an empty name for a new sheet."));
+      return last_style_index;
     }
 
-    for (size_t jSheet = 0u; jSheet < sheets.size(); jSheet++)
+    std::pair<std::pmr::unordered_map<uint32_t, size_t>::iterator, bool> inserted =
+      style_indices.emplace(key, cell_styles.size());
+    if (inserted.second)
     {
-      if (case_insensitive_same(name, sheets.at(jSheet).get_name()))
-      {
-        throw std::runtime_error(std::string("addSheet() received a new sheet with the same name as an existing sheet."));
-      }
+      cell_styles.push_back(cell_style);
     }
 
-    uint32_t sheetId = static_cast<uint32_t>(sheets.size() + 1u);
-    std::string sheet_filename = "xl/worksheets/sheet" + std::to_string(sheetId) + ".xml";
-    std::string sheet_relId = "rId" + std::to_string(sheetId + 1u);
-    sheets.push_back(std::move(Sheet(name, sheet_filename, sheetId, sheet_relId, *this)));
-    return sheets.back();
+    last_style_key = key;
+    last_style_index = inserted.first->second;
+    return last_style_index;
   }
 
   /**
-   * If a style is already stored, this just returns the index of the style.
-   * Otherwise, it stores the style and then returns the index.
+   * Registers cell_style with this Workbook and returns a handle
+   * to it. Cells added with the handle use the style without
+   * looking it up again, which saves time when many cells share a
+   * few styles. The handle is only valid for this Workbook, until
+   * publish().
    */
-  size_t Workbook::addStyle(const cell_style_t &cell_style) noexcept
+  StyleId Workbook::registerStyle(const cell_style_t &cell_style) noexcept
+  {
+    return StyleId(static_cast<uint16_t>(addStyle(cell_style)));
+  }
+
+  /**
+   * Returns the cell_styles index of style after checking that it
+   * belongs to this Workbook. caller names the public method for
+   * the exception message.
+   */
+  uint16_t Workbook::styleIndex(const StyleId style, const char *caller) const noexcept(false)
   {
-    std::vector<cell_style_t>::iterator itr = std::find(cell_styles.begin(), cell_styles.end(), cell_style);
-    if (itr == cell_styles.end())
+    if (style.index >= cell_styles.size())
     {
-      cell_styles.push_back(cell_style);
-      return cell_styles.size() - 1u;
+      throw std::invalid_argument(std::string(caller) + " received a StyleId that was not registered with this Workbook.");
     }
-    else
+    return style.index;
+  }
+
+  /**
+   * Opens the output file specified by the filename argument.
+   * Needed before StreamingSheets can be added; publish() then
+   * completes the file.
+   */
+  void Workbook::open(const std::string &filename) noexcept(false)
+  {
+    if (opened)
+    {
+      throw std::runtime_error(std::string("open() called, but Workbook is already open."));
+    }
+    if (filename.empty())
     {
-      return static_cast<size_t>(itr - cell_styles.begin());
+      throw std::invalid_argument(std::string("open() called with empty filename."));
     }
+    archive.open(filename);
+    opened = true;
   }
 
   /**
@@ -1028,86 +3718,135 @@ namespace BasicWorkbook
    */
   void Workbook::publish(const std::string &filename) noexcept(false)
   {
-    if (sheets.empty())
+    if (sheet_infos.empty())
     {
       throw std::runtime_error(std::string("publish() called, but Workbook has no Sheets."));
     }
-
     if (filename.empty())
     {
       throw std::invalid_argument(std::string("publish() called with empty filename."));
     }
+    this->open(filename);
+    this->publish();
+  }
 
-    archive.open(filename);
+  /**
+   * Completes any StreamingSheets, writes the rest of the
+   * Workbook contents, including GeneratedSheets pulled from their
+   * row generators, to the output file given to open() and then
+   * clears the Workbook.
+   */
+  void Workbook::publish(void) noexcept(false)
+  {
+    if (!opened)
+    {
+      throw std::runtime_error(std::string("publish() called before open()."));
+    }
+    if (sheet_infos.empty())
+    {
+      throw std::runtime_error(std::string("publish() called, but Workbook has no Sheets."));
+    }
 
+    for (std::pmr::deque<StreamingSheet>::iterator streaming_itr = streaming_sheets.begin();
+         streaming_itr != streaming_sheets.end();
+         streaming_itr++)
     {
-      std::string content_types;
-      content_types += u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>";
-      content_types += u8"<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">";
-      content_types += u8"<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>";
-      content_types += u8"<Default Extension=\"xml\" ContentType=\"application/xml\"/>";
-      content_types += u8"<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>";
-    
-      for (size_t jSheet = 0u; jSheet < sheets.size(); jSheet++)
+      if (!streaming_itr->finished)
       {
-        content_types += u8"<Override PartName=\"/" + sheets.at(jSheet).filename + "\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>";
+        streaming_itr->end_file();
       }
+    }
 
-      content_types += u8"<Override PartName=\"/xl/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>";
-      content_types += u8"<Override PartName=\"/docProps/core.xml\" ContentType=\"application/vnd.openxmlformats-package.core-properties+xml\"/>";
-      content_types += u8"<Override PartName=\"/docProps/app.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.extended-properties+xml\"/>";
-      content_types += u8"</Types>";
-      archive.addFile("[Content_Types].xml", content_types);
+    for (size_t jSheet = 0u; jSheet < sheets.size(); jSheet++)
+    {
+      sheets.at(jSheet).share_strings();
     }
+    const bool write_shared_strings = !shared_strings.empty();
+    string_stats.shared_strings = static_cast<uint32_t>(shared_strings.size());
 
     {
-      std::string rels;
-      rels += u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>";
-      rels += u8"<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">";
-      rels += u8"<Relationship Id=\"rId3\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/extended-properties\" Target=\"docProps/app.xml\"/>";
-      rels += u8"<Relationship Id=\"rId2\" Type=\"http://schemas.openxmlformats.org/package/2006/relationships/metadata/core-properties\" Target=\"docProps/core.xml\"/>";
-      rels += u8"<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>";
-      rels += u8"</Relationships>";
-      archive.addFile("_rels/.rels", rels);
+      OutputBuffer content_types = takeBuffer();
+      content_types.append(u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>");
+      content_types.append(u8"<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">");
+      content_types.append(u8"<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>");
+      content_types.append(u8"<Default Extension=\"xml\" ContentType=\"application/xml\"/>");
+      content_types.append(u8"<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>");
+    
+      for (size_t jSheet = 0u; jSheet < sheet_infos.size(); jSheet++)
+      {
+        content_types.append(u8"<Override PartName=\"/");
+        content_types.append(sheet_infos.at(jSheet).filename);
+        content_types.append(u8"\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>");
+      }
+
+      content_types.append(u8"<Override PartName=\"/xl/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>");
+      if (write_shared_strings)
+      {
+        content_types.append(u8"<Override PartName=\"/xl/sharedStrings.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>");
+      }
+      content_types.append(u8"<Override PartName=\"/docProps/core.xml\" ContentType=\"application/vnd.openxmlformats-package.core-properties+xml\"/>");
+      content_types.append(u8"<Override PartName=\"/docProps/app.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.extended-properties+xml\"/>");
+      content_types.append(u8"</Types>");
+      archive.addFile("[Content_Types].xml", content_types.data(), content_types.size());
+      returnBuffer(content_types);
     }
 
     {
-      std::string app;
-      app += u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>";
-      app += u8"<Properties xmlns=\"http://schemas.openxmlformats.org/officeDocument/2006/extended-properties\" xmlns:vt=\"http://schemas.openxmlformats.org/officeDocument/2006/docPropsVTypes\">";
-      app += u8"<Application>BasicWorkbook</Application>";
-      app += u8"<AppVersion>1.0</AppVersion>";
-      app += u8"<DocSecurity>0</DocSecurity>";
-      app += u8"<ScaleCrop>false</ScaleCrop>";
-      app += u8"<HeadingPairs>";
-      app += u8"<vt:vector size=\"2\" baseType=\"variant\">";
-      app += u8"<vt:variant><vt:lpstr>Worksheets</vt:lpstr></vt:variant>";
-      app += u8"<vt:variant><vt:i4>" + std::to_string(sheets.size()) + "</vt:i4></vt:variant>";
-      app += u8"</vt:vector>";
-      app += u8"</HeadingPairs>";
-      app += u8"<TitlesOfParts>";
-      app += u8"<vt:vector size=\"" + std::to_string(sheets.size()) + "\" baseType=\"lpstr\">";
+      OutputBuffer rels = takeBuffer();
+      rels.append(u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>");
+      rels.append(u8"<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">");
+      rels.append(u8"<Relationship Id=\"rId3\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/extended-properties\" Target=\"docProps/app.xml\"/>");
+      rels.append(u8"<Relationship Id=\"rId2\" Type=\"http://schemas.openxmlformats.org/package/2006/relationships/metadata/core-properties\" Target=\"docProps/core.xml\"/>");
+      rels.append(u8"<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>");
+      rels.append(u8"</Relationships>");
+      archive.addFile("_rels/.rels", rels.data(), rels.size());
+      returnBuffer(rels);
+    }
 
-      for (size_t jSheet = 0u; jSheet < sheets.size(); jSheet++)
+    {
+      OutputBuffer app = takeBuffer();
+      app.append(u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>");
+      app.append(u8"<Properties xmlns=\"http://schemas.openxmlformats.org/officeDocument/2006/extended-properties\" xmlns:vt=\"http://schemas.openxmlformats.org/officeDocument/2006/docPropsVTypes\">");
+      app.append(u8"<Application>BasicWorkbook</Application>");
+      app.append(u8"<AppVersion>1.0</AppVersion>");
+      app.append(u8"<DocSecurity>0</DocSecurity>");
+      app.append(u8"<ScaleCrop>false</ScaleCrop>");
+      app.append(u8"<HeadingPairs>");
+      app.append(u8"<vt:vector size=\"2\" baseType=\"variant\">");
+      app.append(u8"<vt:variant><vt:lpstr>Worksheets</vt:lpstr></vt:variant>");
+      app.append(u8"<vt:variant><vt:i4>");
+      app.append(std::to_string(sheet_infos.size()));
+      app.append(u8"</vt:i4></vt:variant>");
+      app.append(u8"</vt:vector>");
+      app.append(u8"</HeadingPairs>");
+      app.append(u8"<TitlesOfParts>");
+      app.append(u8"<vt:vector size=\"");
+      app.append(std::to_string(sheet_infos.size()));
+      app.append(u8"\" baseType=\"lpstr\">");
+
+      for (size_t jSheet = 0u; jSheet < sheet_infos.size(); jSheet++)
       {
-        app += u8"<vt:lpstr>" + sheets.at(jSheet).name + "</vt:lpstr>";
+        app.append(u8"<vt:lpstr>");
+        app.append(sheet_infos.at(jSheet).name);
+        app.append(u8"</vt:lpstr>");
       }
 
-      app += u8"</vt:vector>";
-      app += u8"</TitlesOfParts>";
-      app += u8"<LinksUpToDate>false</LinksUpToDate>";
-      app += u8"<SharedDoc>false</SharedDoc>";
-      app += u8"<HyperlinksChanged>false</HyperlinksChanged>";
-      app += u8"</Properties>";
-      archive.addFile("docProps/app.xml", app);
+      app.append(u8"</vt:vector>");
+      app.append(u8"</TitlesOfParts>");
+      app.append(u8"<LinksUpToDate>false</LinksUpToDate>");
+      app.append(u8"<SharedDoc>false</SharedDoc>");
+      app.append(u8"<HyperlinksChanged>false</HyperlinksChanged>");
+      app.append(u8"</Properties>");
+      archive.addFile("docProps/app.xml", app.data(), app.size());
+      returnBuffer(app);
     }
 
     {
-      std::string core;
-      core += u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>";
-      core += u8"<cp:coreProperties xmlns:cp=\"http://schemas.openxmlformats.org/package/2006/metadata/core-properties\" xmlns:dc=\"http://purl.org/dc/elements/1.1/\" xmlns:dcterms=\"http://purl.org/dc/terms/\" xmlns:dcmitype=\"http://purl.org/dc/dcmitype/\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\">";
-      core += u8"<dc:creator/>";
-      core += u8"<cp:lastModifiedBy/>";
+      OutputBuffer core = takeBuffer();
+      core.append(u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>");
+      core.append(u8"<cp:coreProperties xmlns:cp=\"http://schemas.openxmlformats.org/package/2006/metadata/core-properties\" xmlns:dc=\"http://purl.org/dc/elements/1.1/\" xmlns:dcterms=\"http://purl.org/dc/terms/\" xmlns:dcmitype=\"http://purl.org/dc/dcmitype/\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\">");
+      core.append(u8"<dc:creator/>");
+      core.append(u8"<cp:lastModifiedBy/>");
 
       std::time_t timepoint = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
       std::tm timestruct = IttyZip::gmtime_locked(timepoint);
@@ -1118,225 +3857,329 @@ namespace BasicWorkbook
       {
         throw std::length_error(std::string("Could not assemble timestamp string for core.xml in publish()."));
       }
-      std::string time_string(timestamp);
-
-      core += u8"<dcterms:created xsi:type=\"dcterms:W3CDTF\">" + time_string + "</dcterms:created>";
-      core += u8"<dcterms:modified xsi:type=\"dcterms:W3CDTF\">" + time_string + "</dcterms:modified>";
-      core += u8"</cp:coreProperties>";
-      archive.addFile("docProps/core.xml", core);
-    }
-
-    {
-      std::string rels;
-      rels += u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>";
-      rels += u8"<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">";
-      rels += u8"<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>";
-
-      for (size_t jSheet = 0u; jSheet < sheets.size(); jSheet++)
-      {
-        rels += u8"<Relationship Id=\"";
-        rels += sheets.at(jSheet).relId;
-        rels += u8"\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"";
-        rels += sheets.at(jSheet).filename.substr(3);
-        rels += "\"/>";
-      }
-
-      rels += u8"</Relationships>";
-      archive.addFile("xl/_rels/workbook.xml.rels", rels);
-    }
-
-    {
-      std::string styles;
-      styles += u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>";
-      styles += u8"<styleSheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\">";
-      styles += u8"<numFmts count=\"51\">";
-      styles += u8"<numFmt numFmtId=\"100\" formatCode=\"0\"/>";
-      styles += u8"<numFmt numFmtId=\"101\" formatCode=\"0.0\"/>";
-      styles += u8"<numFmt numFmtId=\"102\" formatCode=\"0.00\"/>";
-      styles += u8"<numFmt numFmtId=\"103\" formatCode=\"0.000\"/>";
-      styles += u8"<numFmt numFmtId=\"104\" formatCode=\"0.0000\"/>";
-      styles += u8"<numFmt numFmtId=\"105\" formatCode=\"0.00000\"/>";
-      styles += u8"<numFmt numFmtId=\"106\" formatCode=\"0.000000\"/>";
-      styles += u8"<numFmt numFmtId=\"107\" formatCode=\"0.0000000\"/>";
-      styles += u8"<numFmt numFmtId=\"108\" formatCode=\"0.00000000\"/>";
-      styles += u8"<numFmt numFmtId=\"109\" formatCode=\"0.000000000\"/>";
-      styles += u8"<numFmt numFmtId=\"110\" formatCode=\"0.0000000000\"/>";
-      styles += u8"<numFmt numFmtId=\"111\" formatCode=\"0.00000000000\"/>";
-      styles += u8"<numFmt numFmtId=\"112\" formatCode=\"0.000000000000\"/>";
-      styles += u8"<numFmt numFmtId=\"113\" formatCode=\"0.0000000000000\"/>";
-      styles += u8"<numFmt numFmtId=\"114\" formatCode=\"0.00000000000000\"/>";
-      styles += u8"<numFmt numFmtId=\"115\" formatCode=\"0.000000000000000\"/>";
-      styles += u8"<numFmt numFmtId=\"116\" formatCode=\"0.0000000000000000\"/>";
-      styles += u8"<numFmt numFmtId=\"117\" formatCode=\"0E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"118\" formatCode=\"0.0E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"119\" formatCode=\"0.00E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"120\" formatCode=\"0.000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"121\" formatCode=\"0.0000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"122\" formatCode=\"0.00000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"123\" formatCode=\"0.000000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"124\" formatCode=\"0.0000000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"125\" formatCode=\"0.00000000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"126\" formatCode=\"0.000000000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"127\" formatCode=\"0.0000000000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"128\" formatCode=\"0.00000000000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"129\" formatCode=\"0.000000000000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"130\" formatCode=\"0.0000000000000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"131\" formatCode=\"0.00000000000000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"132\" formatCode=\"0.000000000000000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"133\" formatCode=\"0.0000000000000000E+0\"/>";
-      styles += u8"<numFmt numFmtId=\"134\" formatCode=\"0%\"/>";
-      styles += u8"<numFmt numFmtId=\"135\" formatCode=\"0.0%\"/>";
-      styles += u8"<numFmt numFmtId=\"136\" formatCode=\"0.00%\"/>";
-      styles += u8"<numFmt numFmtId=\"137\" formatCode=\"0.000%\"/>";
-      styles += u8"<numFmt numFmtId=\"138\" formatCode=\"0.0000%\"/>";
-      styles += u8"<numFmt numFmtId=\"139\" formatCode=\"0.00000%\"/>";
-      styles += u8"<numFmt numFmtId=\"140\" formatCode=\"0.000000%\"/>";
-      styles += u8"<numFmt numFmtId=\"141\" formatCode=\"0.0000000%\"/>";
-      styles += u8"<numFmt numFmtId=\"142\" formatCode=\"0.00000000%\"/>";
-      styles += u8"<numFmt numFmtId=\"143\" formatCode=\"0.000000000%\"/>";
-      styles += u8"<numFmt numFmtId=\"144\" formatCode=\"0.0000000000%\"/>";
-      styles += u8"<numFmt numFmtId=\"145\" formatCode=\"0.00000000000%\"/>";
-      styles += u8"<numFmt numFmtId=\"146\" formatCode=\"0.000000000000%\"/>";
-      styles += u8"<numFmt numFmtId=\"147\" formatCode=\"0.0000000000000%\"/>";
-      styles += u8"<numFmt numFmtId=\"148\" formatCode=\"0.00000000000000%\"/>";
-      styles += u8"<numFmt numFmtId=\"149\" formatCode=\"0.000000000000000%\"/>";
-      styles += u8"<numFmt numFmtId=\"150\" formatCode=\"0.0000000000000000%\"/>";
-      styles += u8"</numFmts>";
-      styles += u8"<fonts count=\"2\"><font>";
-      styles += u8"<sz val=\"12\"/>";
-      styles += u8"<color rgb=\"FF000000\"/>";
-      styles += u8"<name val=\"Calibri\"/>";
-      styles += u8"<family val=\"2\"/>";
-      styles += u8"<scheme val=\"minor\"/>";
-      styles += u8"</font><font><b/>";
-      styles += u8"<sz val=\"12\"/>";
-      styles += u8"<color rgb=\"FF000000\"/>";
-      styles += u8"<name val=\"Calibri\"/>";
-      styles += u8"<family val=\"2\"/>";
-      styles += u8"<scheme val=\"minor\"/>";
-      styles += u8"</font></fonts>";
-      styles += u8"<fills count=\"1\"><fill>";
-      styles += u8"<patternFill patternType=\"none\"/>";
-      styles += u8"</fill></fills>";
-      styles += u8"<borders count=\"1\"><border>";
-      styles += u8"<left/><right/><top/><bottom/><diagonal/>";
-      styles += u8"</border></borders>";
-      styles += u8"<cellStyleXfs count=\"1\">";
-      styles += u8"<xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/>";
-      styles += u8"</cellStyleXfs>";
-      styles += u8"<cellXfs count=\"" + std::to_string(std::max(cell_styles.size(), (size_t)1u)) + "\">";
+      core.append(u8"<dcterms:created xsi:type=\"dcterms:W3CDTF\">");
+      core.append(timestamp, retval);
+      core.append(u8"</dcterms:created>");
+      core.append(u8"<dcterms:modified xsi:type=\"dcterms:W3CDTF\">");
+      core.append(timestamp, retval);
+      core.append(u8"</dcterms:modified>");
+      core.append(u8"</cp:coreProperties>");
+      archive.addFile("docProps/core.xml", core.data(), core.size());
+      returnBuffer(core);
+    }
+
+    {
+      OutputBuffer rels = takeBuffer();
+      rels.append(u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>");
+      rels.append(u8"<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">");
+      rels.append(u8"<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>");
+
+      for (size_t jSheet = 0u; jSheet < sheet_infos.size(); jSheet++)
+      {
+        rels.append(u8"<Relationship Id=\"");
+        rels.append(sheet_infos.at(jSheet).relId);
+        rels.append(u8"\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"");
+        rels.append(std::string_view(sheet_infos.at(jSheet).filename).substr(3u));
+        rels.append("\"/>");
+      }
+
+      if (write_shared_strings)
+      {
+        rels.append(u8"<Relationship Id=\"rId");
+        rels.append(std::to_string(sheet_infos.size() + 2u));
+        rels.append(u8"\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings\" Target=\"sharedStrings.xml\"/>");
+      }
+
+      rels.append(u8"</Relationships>");
+      archive.addFile("xl/_rels/workbook.xml.rels", rels.data(), rels.size());
+      returnBuffer(rels);
+    }
+
+    {
+      OutputBuffer styles = takeBuffer();
+      styles.append(u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>");
+      styles.append(u8"<styleSheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\">");
+      styles.append(u8"<numFmts count=\"51\">");
+      styles.append(u8"<numFmt numFmtId=\"100\" formatCode=\"0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"101\" formatCode=\"0.0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"102\" formatCode=\"0.00\"/>");
+      styles.append(u8"<numFmt numFmtId=\"103\" formatCode=\"0.000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"104\" formatCode=\"0.0000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"105\" formatCode=\"0.00000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"106\" formatCode=\"0.000000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"107\" formatCode=\"0.0000000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"108\" formatCode=\"0.00000000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"109\" formatCode=\"0.000000000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"110\" formatCode=\"0.0000000000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"111\" formatCode=\"0.00000000000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"112\" formatCode=\"0.000000000000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"113\" formatCode=\"0.0000000000000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"114\" formatCode=\"0.00000000000000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"115\" formatCode=\"0.000000000000000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"116\" formatCode=\"0.0000000000000000\"/>");
+      styles.append(u8"<numFmt numFmtId=\"117\" formatCode=\"0E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"118\" formatCode=\"0.0E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"119\" formatCode=\"0.00E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"120\" formatCode=\"0.000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"121\" formatCode=\"0.0000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"122\" formatCode=\"0.00000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"123\" formatCode=\"0.000000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"124\" formatCode=\"0.0000000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"125\" formatCode=\"0.00000000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"126\" formatCode=\"0.000000000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"127\" formatCode=\"0.0000000000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"128\" formatCode=\"0.00000000000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"129\" formatCode=\"0.000000000000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"130\" formatCode=\"0.0000000000000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"131\" formatCode=\"0.00000000000000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"132\" formatCode=\"0.000000000000000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"133\" formatCode=\"0.0000000000000000E+0\"/>");
+      styles.append(u8"<numFmt numFmtId=\"134\" formatCode=\"0%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"135\" formatCode=\"0.0%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"136\" formatCode=\"0.00%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"137\" formatCode=\"0.000%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"138\" formatCode=\"0.0000%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"139\" formatCode=\"0.00000%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"140\" formatCode=\"0.000000%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"141\" formatCode=\"0.0000000%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"142\" formatCode=\"0.00000000%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"143\" formatCode=\"0.000000000%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"144\" formatCode=\"0.0000000000%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"145\" formatCode=\"0.00000000000%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"146\" formatCode=\"0.000000000000%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"147\" formatCode=\"0.0000000000000%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"148\" formatCode=\"0.00000000000000%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"149\" formatCode=\"0.000000000000000%\"/>");
+      styles.append(u8"<numFmt numFmtId=\"150\" formatCode=\"0.0000000000000000%\"/>");
+      styles.append(u8"</numFmts>");
+      styles.append(u8"<fonts count=\"2\"><font>");
+      styles.append(u8"<sz val=\"12\"/>");
+      styles.append(u8"<color rgb=\"FF000000\"/>");
+      styles.append(u8"<name val=\"Calibri\"/>");
+      styles.append(u8"<family val=\"2\"/>");
+      styles.append(u8"<scheme val=\"minor\"/>");
+      styles.append(u8"</font><font><b/>");
+      styles.append(u8"<sz val=\"12\"/>");
+      styles.append(u8"<color rgb=\"FF000000\"/>");
+      styles.append(u8"<name val=\"Calibri\"/>");
+      styles.append(u8"<family val=\"2\"/>");
+      styles.append(u8"<scheme val=\"minor\"/>");
+      styles.append(u8"</font></fonts>");
+      styles.append(u8"<fills count=\"1\"><fill>");
+      styles.append(u8"<patternFill patternType=\"none\"/>");
+      styles.append(u8"</fill></fills>");
+      styles.append(u8"<borders count=\"1\"><border>");
+      styles.append(u8"<left/><right/><top/><bottom/><diagonal/>");
+      styles.append(u8"</border></borders>");
+      styles.append(u8"<cellStyleXfs count=\"1\">");
+      styles.append(u8"<xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/>");
+      styles.append(u8"</cellStyleXfs>");
+      styles.append(u8"<cellXfs count=\"");
+      styles.append(std::to_string(std::max(cell_styles.size(), (size_t)1u)));
+      styles.append(u8"\">");
       
       if (cell_styles.empty())
       {
-        styles += u8"<xf numFmtId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/>";
+        styles.append(u8"<xf numFmtId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/>");
       }
       else
       {
         for (size_t jStyle = 0u; jStyle < cell_styles.size(); jStyle++)
         {
           cell_style_t this_style = cell_styles.at(jStyle);
-          styles += u8"<xf numFmtId=\"" + std::to_string(static_cast<uint8_t>(this_style.num_format)) + "\" ";
+          styles.append(u8"<xf numFmtId=\"");
+          styles.append(std::to_string(static_cast<uint8_t>(this_style.num_format)));
+          styles.append(u8"\" ");
           
           if (this_style.bold)
           {
-            styles += u8"fontId=\"1\" ";
+            styles.append(u8"fontId=\"1\" ");
           }
           else
           {
-            styles += u8"fontId=\"0\" ";
+            styles.append(u8"fontId=\"0\" ");
           }
           
-          styles += u8"fillId=\"0\" borderId=\"0\" xfId=\"0\" ";
-          styles += u8"applyNumberFormat=\"1\" applyFont=\"1\" applyAlignment=\"1\">";
-          styles += u8"<alignment horizontal=\"";
+          styles.append(u8"fillId=\"0\" borderId=\"0\" xfId=\"0\" ");
+          styles.append(u8"applyNumberFormat=\"1\" applyFont=\"1\" applyAlignment=\"1\">");
+          styles.append(u8"<alignment horizontal=\"");
           
           switch (this_style.horiz_align)
           {
             case HorizontalAlignment::LEFT:
-              styles += u8"left";
+              styles.append(u8"left");
               break;
             case HorizontalAlignment::CENTER:
-              styles += u8"center";
+              styles.append(u8"center");
               break;
             case HorizontalAlignment::RIGHT:
-              styles += u8"right";
+              styles.append(u8"right");
               break;
             default:
-              styles += u8"general";
+              styles.append(u8"general");
               break;
           }
 
-          styles += "\" vertical=\"";
+          styles.append("\" vertical=\"");
 
           switch (this_style.vert_align)
           {
             case VerticalAlignment::CENTER:
-              styles += u8"center";
+              styles.append(u8"center");
               break;
             case VerticalAlignment::TOP:
-              styles += u8"top";
+              styles.append(u8"top");
               break;
             default:
-              styles += u8"bottom";
+              styles.append(u8"bottom");
               break;
           }
 
-          styles += u8"\" wrapText=\"";
+          styles.append(u8"\" wrapText=\"");
 
           if (this_style.wrap_text)
           {
-            styles += u8"true";
+            styles.append(u8"true");
           }
           else
           {
-            styles += u8"false";
+            styles.append(u8"false");
           }
 
-          styles += u8"\"/></xf>";
+          styles.append(u8"\"/></xf>");
         }
       }
       
-      styles += u8"</cellXfs>";
-      styles += u8"<cellStyles count=\"1\">";
-      styles += u8"<cellStyle name=\"Normal\" xfId=\"0\" builtinId=\"0\"/>";
-      styles += u8"</cellStyles>";
-      styles += u8"<dxfs count=\"0\"/>";
-      styles += u8"<tableStyles count=\"0\"/>";
-      styles += u8"</styleSheet>";
-      archive.addFile("xl/styles.xml", styles);
+      styles.append(u8"</cellXfs>");
+      styles.append(u8"<cellStyles count=\"1\">");
+      styles.append(u8"<cellStyle name=\"Normal\" xfId=\"0\" builtinId=\"0\"/>");
+      styles.append(u8"</cellStyles>");
+      styles.append(u8"<dxfs count=\"0\"/>");
+      styles.append(u8"<tableStyles count=\"0\"/>");
+      styles.append(u8"</styleSheet>");
+      archive.addFile("xl/styles.xml", styles.data(), styles.size());
+      returnBuffer(styles);
     }
 
     {
-      std::string workbook;
-      workbook += u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>";
-      workbook += u8"<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\">";
-      workbook += u8"<sheets>";
+      OutputBuffer workbook = takeBuffer();
+      workbook.append(u8"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>");
+      workbook.append(u8"<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" xmlns:mc=\"http://schemas.openxmlformats.org/markup-compatibility/2006\">");
+      workbook.append(u8"<sheets>");
       
-      for (size_t jSheet = 0u; jSheet < sheets.size(); jSheet++)
+      for (size_t jSheet = 0u; jSheet < sheet_infos.size(); jSheet++)
       {
-        workbook += u8"<sheet name=\"";
-        workbook += sheets.at(jSheet).name;
-        workbook += u8"\" sheetId=\"";
-        workbook += std::to_string(sheets.at(jSheet).sheetId);
-        workbook += u8"\" r:id=\"";
-        workbook += sheets.at(jSheet).relId;
-        workbook += u8"\"/>";
+        workbook.append(u8"<sheet name=\"");
+        workbook.append(sheet_infos.at(jSheet).name);
+        workbook.append(u8"\" sheetId=\"");
+        workbook.append(std::to_string(sheet_infos.at(jSheet).sheetId));
+        workbook.append(u8"\" r:id=\"");
+        workbook.append(sheet_infos.at(jSheet).relId);
+        workbook.append(u8"\"/>");
       }
 
-      workbook += u8"</sheets>";
-      workbook += u8"<calcPr fullPrecision=\"1\"/>";
-      workbook += u8"</workbook>";
-      archive.addFile("xl/workbook.xml", workbook);
+      workbook.append(u8"</sheets>");
+      workbook.append(u8"<calcPr fullPrecision=\"1\"/>");
+      workbook.append(u8"</workbook>");
+      archive.addFile("xl/workbook.xml", workbook.data(), workbook.size());
+      returnBuffer(workbook);
+    }
+
+    if (write_shared_strings)
+    {
+      writeSharedStrings();
     }
 
-    while (!sheets.empty())
+    writeSheets();
+    for (std::pmr::deque<GeneratedSheet>::iterator generated_itr = generated_sheets.begin();
+         generated_itr != generated_sheets.end();
+         generated_itr++)
     {
-      archive.addFile(sheets.back().filename, sheets.back().generate_file());
-      sheets.pop_back();
+      generated_itr->write_file();
     }
     sheets.clear();
+    streaming_sheets.clear();
+    generated_sheets.clear();
+    sheet_infos.clear();
+    clearStrings();
+    published_string_stats = string_stats;
+    string_stats = string_stats_t();
 
     archive.finalize();
+    opened = false;
+  }
+
+  /**
+   * WorkbookPool basic constructor; keeps up to one idle Workbook
+   * per hardware thread.
+   */
+  WorkbookPool::WorkbookPool(void) noexcept(false) : WorkbookPool(std::max(std::thread::hardware_concurrency(), 1u))
+  {
+    /* Nothing. */
+  }
+
+  /**
+   * WorkbookPool constructor that keeps up to max_idle_ idle
+   * Workbooks.
+   */
+  WorkbookPool::WorkbookPool(const size_t max_idle_) noexcept(false) : idle(), max_idle(max_idle_)
+  {
+    idle.reserve(max_idle);
+  }
+
+  /**
+   * Returns an idle Workbook from the pool, or a new one if there
+   * is none. The Workbook behaves like a newly constructed one.
+   * May be called from any thread.
+   */
+  std::unique_ptr<Workbook> WorkbookPool::acquire(void) noexcept(false)
+  {
+    {
+      std::lock_guard<std::mutex> idle_lock(idle_mutex);
+      if (!idle.empty())
+      {
+        std::unique_ptr<Workbook> workbook = std::move(idle.back());
+        idle.pop_back();
+        return workbook;
+      }
+    }
+
+    std::unique_ptr<std::pmr::memory_resource> memory(new std::pmr::synchronized_pool_resource());
+    std::unique_ptr<Workbook> workbook(new Workbook(memory.get()));
+    workbook->owned_memory = std::move(memory);
+    workbook->default_thread_count = 0u;
+    workbook->thread_count = workbook->default_thread_count;
+    return workbook;
+  }
+
+  /**
+   * Resets workbook and keeps it for a later acquire(), or destroys
+   * it if the pool already holds as many idle Workbooks as it may.
+   * workbook need not have come from this pool. May be called from
+   * any thread.
+   */
+  void WorkbookPool::release(std::unique_ptr<Workbook> workbook) noexcept(false)
+  {
+    if (!workbook)
+    {
+      throw std::invalid_argument(std::string("release() received an empty Workbook pointer."));
+    }
+    workbook->reset();
+
+    std::lock_guard<std::mutex> idle_lock(idle_mutex);
+    if (idle.size() < max_idle)
+    {
+      idle.push_back(std::move(workbook));
+    }
+  }
+
+  /**
+   * The number of idle Workbooks the pool is holding.
+   */
+  size_t WorkbookPool::idleCount(void) const noexcept
+  {
+    std::lock_guard<std::mutex> idle_lock(idle_mutex);
+    return idle.size();
   }
 }
 
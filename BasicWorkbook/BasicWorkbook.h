@@ -21,9 +21,16 @@
 
 #include <cinttypes>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <set>
 #include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include "IttyZip.h"
 
 namespace BasicWorkbook
@@ -36,6 +43,12 @@ namespace BasicWorkbook
   const uint32_t MAX_ROW = 1048576u;
   const uint32_t MAX_COL = 16384u;
 
+  /**
+   * The longest possible cell reference in mixedref format,
+   * e.g. XFD1048576, in characters.
+   */
+  const size_t MAX_MIXEDREF_LEN = 10u;
+
   /**
    * These minimum and maximum column widths (in characters)
    * are the same limits as those in a popular office
@@ -192,27 +205,162 @@ namespace BasicWorkbook
     bool bold;
   } cell_style_t;
 
+  /**
+   * How the text of string cells is written to Sheet .xml files.
+   * INLINE:   each cell holds its own text (t="inlineStr").
+   * SHARED:   each distinct text is written once to the workbook's
+   *           xl/sharedStrings.xml and cells refer to it by index.
+   * ADAPTIVE: columns whose string values repeat often enough are
+   *           written as in SHARED, the rest as in INLINE. See
+   *           Workbook::setSharedStringThreshold().
+   */
+  enum class StringMode : uint8_t
+  {
+    INLINE = 0u,
+    SHARED = 1u,
+    ADAPTIVE = 2u
+  };
+
+  /**
+   * The default share of repeated values at which an ADAPTIVE
+   * column is written to the shared strings table.
+   */
+  const double DEFAULT_SHARED_STRING_THRESHOLD = 0.5;
+
+  /**
+   * Counts of the string cells in one column of a sheet and of
+   * those among them whose value was not yet in the Workbook's
+   * string pool when the cell was added. The column's repetition
+   * rate is 1 - new_values / cells.
+   */
+  typedef struct
+  {
+    uint32_t cells;
+    uint32_t new_values;
+  } string_column_stats_t;
+
+  /**
+   * How the string cells of the last published Workbook were
+   * written; see Workbook::getStringStats(). Columns count the
+   * Sheet columns with string cells. StreamingSheet cells, whose
+   * encoding is chosen as they are added, are counted in cells
+   * only. shared_strings is the length of xl/sharedStrings.xml.
+   */
+  typedef struct
+  {
+    uint64_t shared_cells;
+    uint64_t inline_cells;
+    uint32_t shared_columns;
+    uint32_t inline_columns;
+    uint32_t shared_strings;
+  } string_stats_t;
+
   /**
    * Define the default cell styles.
    */
   const cell_style_t generic_style = {NumberFormat::GENERAL, HorizontalAlignment::GENERAL, VerticalAlignment::BOTTOM, false, false};
   const cell_style_t generic_string_style = {NumberFormat::TEXT, HorizontalAlignment::GENERAL, VerticalAlignment::BOTTOM, false, false};
 
+  /**
+   * Opaque handle to a cell style registered with
+   * Workbook::registerStyle(). Cells added with a StyleId skip
+   * the style lookup that a cell_style_t argument requires.
+   * A default constructed StyleId refers to generic_style.
+   */
+  class StyleId
+  {
+  public:
+    StyleId(void) noexcept : index(0u) {}
+
+  private:
+    explicit StyleId(const uint16_t index_) noexcept : index(index_) {}
+
+    /**
+     * Position of the style in the Workbook's cell_styles.
+     */
+    uint16_t index;
+
+    friend class Workbook;
+  };
+
+  /**
+   * The location of a formula's text in the Sheet's
+   * formula_text arena.
+   */
+  typedef struct
+  {
+    uint32_t offset;
+    uint32_t length;
+  } text_ref_t;
+
+  /**
+   * The value of a single cell. Number cells use num_val.
+   * Formula cells store their text in the Sheet's formula_text
+   * arena and use formula to find it. String cells store their
+   * text in the Workbook's string pool and use text_index, its
+   * position in the pool.
+   */
+  typedef union
+  {
+    double num_val;
+    uint32_t text_index;
+    text_ref_t formula;
+  } cell_value_t;
+
   /**
    * This is the representation of a single cell in
-   * BasicWorkbook. Both formula type cells and
-   * string type cells store their value in the
-   * same string.
+   * BasicWorkbook as it is handed to Sheet::insert_cell().
+   * The row is passed alongside it. Once inserted, the
+   * fields are stored in the parallel arrays of a
+   * cell_block_t.
    */
   typedef struct
   {
-    integerref_t integerref;
+    cell_value_t value;
+    uint32_t col;
+    uint16_t style_index;
     CellType type;
-    size_t style_index;
-    double num_val;
-    std::string str_fml_val;
   } cell_t;
 
+  /**
+   * The number of consecutive rows grouped into a single
+   * cell_block_t.
+   */
+  const uint32_t CELL_BLOCK_ROWS = 64u;
+
+  /**
+   * Sheet::add_columns() transposes column-major numbers into the
+   * row-major cell values of a cell block in tiles of
+   * CELL_BLOCK_ROWS rows by this many columns, which fit
+   * comfortably in the L1 data cache.
+   */
+  const uint32_t TRANSPOSE_TILE_COLS = 16u;
+
+  /**
+   * The cells of up to CELL_BLOCK_ROWS consecutive rows of a
+   * Sheet, stored as a structure of arrays. Rows with cells
+   * in block number block_index lie in
+   * [block_index*CELL_BLOCK_ROWS + 1, (block_index+1)*CELL_BLOCK_ROWS].
+   *
+   * rows holds the block's non-empty rows in ascending order
+   * and row_starts the position of each row's first cell. A
+   * row's cells run up to the next row's start (or the end of
+   * the arrays) and are sorted by column. cols, style_indices,
+   * types and values are indexed together, one entry per cell,
+   * so a dense numeric block is walked as a few contiguous
+   * arrays during Sheet .xml file generation.
+   */
+  typedef struct
+  {
+    uint32_t block_index;
+    std::pmr::vector<uint32_t> rows;
+    std::pmr::vector<uint32_t> row_starts;
+    std::pmr::vector<uint32_t> cols;
+    std::pmr::vector<uint16_t> style_indices;
+    std::pmr::vector<CellType> types;
+    std::pmr::vector<cell_value_t> values;
+  } cell_block_t;
+
   /**
    * This type holds the starting (upper left) reference and
    * the ending (lower right) reference for a merged cell.
@@ -223,10 +371,34 @@ namespace BasicWorkbook
     integerref_t end_ref;
   } merged_cell_t;
 
-  struct cell_sort_compare
+  /**
+   * Workbook level description of a Sheet or StreamingSheet.
+   * The Workbook keeps one of these per sheet, in the order the
+   * sheets were added, to generate the workbook-wide .xml files.
+   */
+  typedef struct
   {
-    bool operator() (const cell_t &a, const cell_t &b) const noexcept;
-  };
+    std::string name;
+    std::string filename;
+    uint32_t sheetId;
+    std::string relId;
+  } sheet_info_t;
+
+  /**
+   * Sheet .xml that is streamed into the Workbook archive, rather
+   * than generated whole, is collected in a buffer of about this
+   * many bytes before it is passed on. The buffer is small enough
+   * to still be in cache when the archive computes its CRC-32.
+   */
+  const size_t STREAM_BUFFER_SIZE = 65536u;
+
+  /**
+   * When publish() uses more than one thread, a Sheet with at
+   * least twice this many cells is serialized as row range
+   * fragments of about this many cells each, generated in
+   * parallel and written to its .xml file in order.
+   */
+  const size_t SHEET_FRAGMENT_CELLS = 262144u;
 
   struct merged_cell_sort_compare
   {
@@ -248,8 +420,77 @@ namespace BasicWorkbook
   integerref_t mixedref_to_integerref(const std::string &mixedref) noexcept(false);
   std::string integerref_to_mixedref(const uint32_t row, const uint32_t col) noexcept(false);
   std::string integerref_to_mixedref(const integerref_t &integerref) noexcept(false);
+  size_t write_mixedref(char *output, const uint32_t row, const uint32_t col) noexcept(false);
   bool case_insensitive_same(const std::string &a, const std::string &b) noexcept;
 
+  /**
+   * An append-only character buffer that sheet .xml is written
+   * into. Unlike std::string it grows without zero filling, and
+   * callers may write directly into reserved space: make_room(n)
+   * returns a pointer with room for n more characters, and
+   * commit() then records how far the caller wrote. clear() keeps
+   * the capacity, so a buffer can be reused for many files.
+   * Storage comes from the given memory resource.
+   */
+  class OutputBuffer
+  {
+  public:
+    explicit OutputBuffer(std::pmr::memory_resource *memory_ = std::pmr::get_default_resource()) noexcept;
+    OutputBuffer(OutputBuffer &&other) noexcept;
+    OutputBuffer& operator=(OutputBuffer &&other) noexcept;
+    ~OutputBuffer(void) noexcept;
+    void reserve(const size_t new_capacity) noexcept(false);
+    char* make_room(const size_t count) noexcept(false);
+    void commit(char *end) noexcept;
+    void append(const char *text, const size_t length) noexcept(false);
+    void append(const char *text) noexcept(false);
+    void append(const std::string_view text) noexcept(false);
+    void truncate(const size_t new_length) noexcept;
+    void clear(void) noexcept;
+    void release(void) noexcept;
+    const char* data(void) const noexcept;
+    size_t size(void) const noexcept;
+    size_t capacity(void) const noexcept;
+
+  private:
+    std::pmr::memory_resource *memory;
+    char *storage;
+    size_t length;
+    size_t allocated;
+  };
+
+  /**
+   * The number of bytes in each chunk of a TextArena.
+   */
+  const size_t TEXT_ARENA_CHUNK = 65536u;
+
+  /**
+   * A bump allocator for strings that live until the arena is
+   * cleared. Strings are copied into chunks of TEXT_ARENA_CHUNK
+   * bytes (or one chunk of their own if they are longer) that
+   * never move, so the views store() returns stay valid, and
+   * clearing the arena drops all of them at once. Cleared chunks
+   * are kept and filled again by later strings; they are only
+   * given back to the memory resource they came from when the
+   * arena is destroyed.
+   */
+  class TextArena
+  {
+  public:
+    explicit TextArena(std::pmr::memory_resource *memory_ = std::pmr::get_default_resource()) noexcept;
+    TextArena(const TextArena &other) = delete;
+    TextArena& operator=(const TextArena &other) = delete;
+    ~TextArena(void) noexcept;
+    std::string_view store(const std::string_view text) noexcept(false);
+    void clear(void) noexcept;
+
+  private:
+    std::pmr::memory_resource *memory;
+    std::pmr::vector<std::pair<char*, size_t> > chunks;
+    size_t current_chunk;
+    size_t chunk_used;
+  };
+
   class Workbook;
 
   class Sheet
@@ -258,21 +499,36 @@ namespace BasicWorkbook
     void add_number_cell(const uint32_t row, const uint32_t col, const double number, const cell_style_t &cell_style = generic_style) noexcept(false);
     void add_number_cell(const integerref_t &integerref, const double number, const cell_style_t &cell_style = generic_style) noexcept(false);
     void add_number_cell(const std::string &mixedref, const double number, const cell_style_t &cell_style = generic_style) noexcept(false);
+    void add_number_cell(const uint32_t row, const uint32_t col, const double number, const StyleId style) noexcept(false);
+    void add_number_cell(const integerref_t &integerref, const double number, const StyleId style) noexcept(false);
+    void add_number_cell(const std::string &mixedref, const double number, const StyleId style) noexcept(false);
     void add_merged_number_cell(const uint32_t start_row, const uint32_t start_col, const uint32_t end_row, const uint32_t end_col, const double number, const cell_style_t &cell_style = generic_style) noexcept(false);
     void add_merged_number_cell(const integerref_t &start_ref, const integerref_t &end_ref, const double number, const cell_style_t &cell_style = generic_style) noexcept(false);
     void add_merged_number_cell(const std::string &start_ref, const std::string &end_ref, const double number, const cell_style_t &cell_style = generic_style) noexcept(false);
     void add_formula_cell(const uint32_t row, const uint32_t col, const std::string &formula, const cell_style_t &cell_style = generic_style) noexcept(false);
     void add_formula_cell(const integerref_t &integerref, const std::string &formula, const cell_style_t &cell_style = generic_style) noexcept(false);
     void add_formula_cell(const std::string &mixedref, const std::string &formula, const cell_style_t &cell_style = generic_style) noexcept(false);
+    void add_formula_cell(const uint32_t row, const uint32_t col, const std::string &formula, const StyleId style) noexcept(false);
+    void add_formula_cell(const integerref_t &integerref, const std::string &formula, const StyleId style) noexcept(false);
+    void add_formula_cell(const std::string &mixedref, const std::string &formula, const StyleId style) noexcept(false);
     void add_merged_formula_cell(const uint32_t start_row, const uint32_t start_col, const uint32_t end_row, const uint32_t end_col, const std::string &formula, const cell_style_t &cell_style = generic_style) noexcept(false);
     void add_merged_formula_cell(const integerref_t &start_ref, const integerref_t &end_ref, const std::string &formula, const cell_style_t &cell_style = generic_style) noexcept(false);
     void add_merged_formula_cell(const std::string &start_ref, const std::string &end_ref, const std::string &formula, const cell_style_t &cell_style = generic_style) noexcept(false);
     void add_string_cell(const uint32_t row, const uint32_t col, const std::string &value, const cell_style_t &cell_style = generic_string_style) noexcept(false);
     void add_string_cell(const integerref_t &integerref, const std::string &value, const cell_style_t &cell_style = generic_string_style) noexcept(false);
     void add_string_cell(const std::string &mixedref, const std::string &value, const cell_style_t &cell_style = generic_string_style) noexcept(false);
+    void add_string_cell(const uint32_t row, const uint32_t col, const std::string &value, const StyleId style) noexcept(false);
+    void add_string_cell(const integerref_t &integerref, const std::string &value, const StyleId style) noexcept(false);
+    void add_string_cell(const std::string &mixedref, const std::string &value, const StyleId style) noexcept(false);
     void add_merged_string_cell(const uint32_t start_row, const uint32_t start_col, const uint32_t end_row, const uint32_t end_col, const std::string &value, const cell_style_t &cell_style = generic_string_style) noexcept(false);
     void add_merged_string_cell(const integerref_t &start_ref, const integerref_t &end_ref, const std::string &value, const cell_style_t &cell_style = generic_string_style) noexcept(false);
     void add_merged_string_cell(const std::string &start_ref, const std::string &end_ref, const std::string &value, const cell_style_t &cell_style = generic_string_style) noexcept(false);
+    void add_row(const uint32_t row, const uint32_t first_col, const double *values, const size_t count, const StyleId style) noexcept(false);
+    void add_row(const uint32_t row, const uint32_t first_col, const std::string *values, const size_t count, const StyleId style) noexcept(false);
+    void add_block(const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const double *values, const size_t stride, const StyleId style) noexcept(false);
+    void add_block(const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const std::string *values, const size_t stride, const StyleId style) noexcept(false);
+    void add_columns(const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const double *const *columns, const StyleId style) noexcept(false);
+    void add_columns(const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const std::string *const *columns, const StyleId style) noexcept(false);
     void set_column_width(const uint32_t col, const double width) noexcept(false);
     void set_column_width(const std::string &column, const double width) noexcept(false);
     void set_row_height(const uint32_t row, const double height) noexcept(false);
@@ -281,11 +537,30 @@ namespace BasicWorkbook
   private:
     Sheet(const std::string &name_, const std::string &filename_, const uint32_t sheetId_, const std::string &relId_, Workbook &workbook_) noexcept(false);
     void add_empty_cell(const integerref_t &integerref, const cell_style_t &cell_style) noexcept(false);
-    std::string generate_file(void) const noexcept;
+    bool insert_cell(const uint32_t row, const cell_t &cell) noexcept(false);
+    cell_value_t* insert_run(const uint32_t row, const uint32_t first_col, const uint32_t count, const uint16_t style_index, const CellType type) noexcept(false);
+    cell_value_t* insert_group_runs(const uint32_t row, const uint32_t rows, const uint32_t first_col, const uint32_t count, const uint16_t style_index, const CellType type, std::pmr::vector<size_t> &run_offsets) noexcept(false);
+    bool run_is_free(const uint32_t row, const uint32_t first_col, const uint32_t count) const noexcept;
+    void insert_number_block(const char *caller, const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const double *values, const size_t stride, const StyleId style) noexcept(false);
+    void insert_string_block(const char *caller, const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const std::string *values, const size_t stride, const StyleId style) noexcept(false);
+    bool check_block(const uint32_t row, const uint32_t col, const uint32_t rows, const uint32_t cols, const void *values, const size_t stride, const char *caller) const noexcept(false);
+    uint32_t block_group_rows(const uint32_t row, const uint32_t rows) const noexcept;
+    void add_used_columns(const uint32_t first_col, const uint32_t count) noexcept(false);
+    void generate_file(OutputBuffer &file, const bool compact) const noexcept(false);
+    void write_file(OutputBuffer &chunk, const bool compact) const noexcept(false);
+    size_t estimate_file_size(void) const noexcept;
+    size_t estimate_rows_size(const size_t first_block, const size_t end_block, const bool compact) const noexcept;
+    void append_file_start(OutputBuffer &file) const noexcept(false);
+    void append_rows(OutputBuffer &file, const size_t first_block, const size_t end_block, const bool compact, IttyZip::IttyZip *archive = nullptr) const noexcept(false);
+    void append_file_end(OutputBuffer &file) const noexcept(false);
+    std::vector<size_t> fragment_bounds(const size_t fragment_cells) const noexcept(false);
+    size_t cell_count(void) const noexcept;
+    void release_cells(void) noexcept(false);
+    void share_strings(void) noexcept(false);
 
     /**
-     * Reference to the enclosing workbook.
-     * Solely used to call workbook.addStyle().
+     * Reference to the enclosing workbook, used to call
+     * workbook.addStyle() and to reach the shared string pool.
      */
     Workbook &workbook;
 
@@ -321,34 +596,54 @@ namespace BasicWorkbook
      * cells so that the width of all non-empty columns can
      * be set to best fit if not otherwise specified.
      */
-    std::set<uint32_t> used_columns;
+    std::pmr::set<uint32_t> used_columns;
 
     /**
      * This set holds any custom column widths.
      * The column index is the first element of the pair;
      * the width is the second element of the pair.
      */
-    std::set<std::pair<uint32_t,double>, column_widths_sort_compare> column_widths;
+    std::pmr::set<std::pair<uint32_t,double>, column_widths_sort_compare> column_widths;
 
     /**
      * This set holds any custom row heights.
      * The row index is the first element of the pair;
      * the height is the second element of the pair.
      */
-    std::set<std::pair<uint32_t,double>, row_heights_sort_compare> row_heights;
+    std::pmr::set<std::pair<uint32_t,double>, row_heights_sort_compare> row_heights;
 
     /**
-     * This Sheet's cells are stored in a set so that they are
-     * maintained in sorted order for easier Sheet .xml file
-     * generation later. This also helps detect duplicate additions
-     * of a cell at the same reference.
+     * This Sheet's cells are stored in blocks of consecutive rows.
+     * cell_blocks is kept sorted by block_index, and within each
+     * block rows and columns are kept sorted, so that the cells are
+     * maintained in sorted order for easier Sheet .xml file generation
+     * later. This also helps detect duplicate additions of a cell at
+     * the same reference.
+     *
+     * Cells added in row-major order are simply appended; other
+     * cells are placed with a binary search. See insert_cell().
      *
      * Cells are added through the various overloaded methods
      * Sheet::add_number_cell()
      * Sheet::add_formula_cell()
      * Sheet::add_string_cell()
      */
-    std::set<cell_t, cell_sort_compare> cells;
+    std::pmr::vector<cell_block_t> cell_blocks;
+
+    /**
+     * The text of this Sheet's formula cells, back to back, found
+     * through cell_value_t::formula. The text of string cells is
+     * kept in the Workbook's string pool instead.
+     */
+    OutputBuffer formula_text;
+
+    /**
+     * Repetition counts of the string cells in each column,
+     * indexed by column number, and at publish() whether each
+     * column is written to the shared strings table.
+     */
+    std::pmr::vector<string_column_stats_t> string_columns;
+    std::pmr::vector<bool> shared_columns;
 
     /**
      * Merged cell references are stored in this set because these
@@ -356,34 +651,399 @@ namespace BasicWorkbook
      * Duplicate / overlapping merged cells is handled implicitly
      * by ordinary duplicate cell detection.
      */
-    std::set<merged_cell_t, merged_cell_sort_compare> merged_cells;
+    std::pmr::set<merged_cell_t, merged_cell_sort_compare> merged_cells;
 
     friend class Workbook;
   };
 
+  /**
+   * StreamingSheet is a write-only alternative to Sheet for sheets
+   * too large to hold in memory. Cells must be added in row-major
+   * order (row by row, left to right within a row) and are turned
+   * into .xml and written to the open Workbook archive as they
+   * arrive. Only column widths, row heights not yet used, merged
+   * cell ranges and (through the Workbook) cell styles are kept,
+   * so memory use does not grow with the number of rows.
+   *
+   * The archive can only hold one partly written file at a time.
+   * Adding cells to a StreamingSheet therefore completes any other
+   * StreamingSheet that was being written, after which no more
+   * cells may be added to that other sheet.
+   *
+   * Column widths must be set before the first cell is added.
+   * Unlike Sheet, columns without a custom width are left at the
+   * default width rather than set to best fit. Row heights must be
+   * set before the first cell of the row is added.
+   */
+  class StreamingSheet
+  {
+  public:
+    void add_number_cell(const uint32_t row, const uint32_t col, const double number, const cell_style_t &cell_style = generic_style) noexcept(false);
+    void add_number_cell(const integerref_t &integerref, const double number, const cell_style_t &cell_style = generic_style) noexcept(false);
+    void add_number_cell(const std::string &mixedref, const double number, const cell_style_t &cell_style = generic_style) noexcept(false);
+    void add_number_cell(const uint32_t row, const uint32_t col, const double number, const StyleId style) noexcept(false);
+    void add_number_cell(const integerref_t &integerref, const double number, const StyleId style) noexcept(false);
+    void add_number_cell(const std::string &mixedref, const double number, const StyleId style) noexcept(false);
+    void add_formula_cell(const uint32_t row, const uint32_t col, const std::string &formula, const cell_style_t &cell_style = generic_style) noexcept(false);
+    void add_formula_cell(const integerref_t &integerref, const std::string &formula, const cell_style_t &cell_style = generic_style) noexcept(false);
+    void add_formula_cell(const std::string &mixedref, const std::string &formula, const cell_style_t &cell_style = generic_style) noexcept(false);
+    void add_formula_cell(const uint32_t row, const uint32_t col, const std::string &formula, const StyleId style) noexcept(false);
+    void add_formula_cell(const integerref_t &integerref, const std::string &formula, const StyleId style) noexcept(false);
+    void add_formula_cell(const std::string &mixedref, const std::string &formula, const StyleId style) noexcept(false);
+    void add_string_cell(const uint32_t row, const uint32_t col, const std::string &value, const cell_style_t &cell_style = generic_string_style) noexcept(false);
+    void add_string_cell(const integerref_t &integerref, const std::string &value, const cell_style_t &cell_style = generic_string_style) noexcept(false);
+    void add_string_cell(const std::string &mixedref, const std::string &value, const cell_style_t &cell_style = generic_string_style) noexcept(false);
+    void add_string_cell(const uint32_t row, const uint32_t col, const std::string &value, const StyleId style) noexcept(false);
+    void add_string_cell(const integerref_t &integerref, const std::string &value, const StyleId style) noexcept(false);
+    void add_string_cell(const std::string &mixedref, const std::string &value, const StyleId style) noexcept(false);
+    void merge_cells(const integerref_t &start_ref, const integerref_t &end_ref) noexcept(false);
+    void merge_cells(const std::string &start_ref, const std::string &end_ref) noexcept(false);
+    void set_column_width(const uint32_t col, const double width) noexcept(false);
+    void set_column_width(const std::string &column, const double width) noexcept(false);
+    void set_row_height(const uint32_t row, const double height) noexcept(false);
+    std::string get_name(void) const noexcept;
+
+  private:
+    StreamingSheet(const std::string &name_, const std::string &filename_, Workbook &workbook_) noexcept(false);
+    void add_cell(const char *caller, const integerref_t &integerref, const CellType type, const StyleId style, const double num_val, const std::string_view text) noexcept(false);
+    void begin_file(void) noexcept(false);
+    void flush(void) noexcept(false);
+    void end_file(void) noexcept(false);
+
+    /**
+     * Reference to the enclosing workbook, used to call
+     * workbook.addStyle() and to write to workbook.archive.
+     */
+    Workbook &workbook;
+
+    /**
+     * The name of the StreamingSheet as displayed on its tab and
+     * the filename of its .xml file in the Workbook ZIP archive.
+     */
+    std::string name;
+    std::string filename;
+
+    /**
+     * Custom column widths, written when the first cell is added,
+     * and custom heights of rows not yet written. A row's height is
+     * dropped once the row is written.
+     */
+    std::pmr::set<std::pair<uint32_t,double>, column_widths_sort_compare> column_widths;
+    std::pmr::set<std::pair<uint32_t,double>, row_heights_sort_compare> row_heights;
+
+    /**
+     * Merged cell ranges, written after the last row.
+     */
+    std::pmr::set<merged_cell_t, merged_cell_sort_compare> merged_cells;
+
+    /**
+     * Running repetition counts of the string cells added to each
+     * column, indexed by column number. Not kept in
+     * StringMode::INLINE.
+     */
+    std::pmr::vector<string_column_stats_t> string_columns;
+
+    /**
+     * The reference of the last cell added; both are 0 before
+     * the first cell. Every new cell must come after it.
+     */
+    uint32_t last_row;
+    uint32_t last_col;
+
+    /**
+     * started is true once this StreamingSheet's file has been
+     * begun in the archive; finished is true once it is complete.
+     */
+    bool started;
+    bool finished;
+
+    /**
+     * .xml not yet passed to the archive. Flushed whenever it
+     * reaches STREAM_BUFFER_SIZE bytes.
+     */
+    OutputBuffer write_buffer;
+
+    friend class Workbook;
+  };
+
+  class GeneratedSheet;
+
+  /**
+   * The cells of one row of a GeneratedSheet, as handed to its row
+   * generator. Cells must be added left to right and are turned
+   * into .xml as they arrive. String cells are always written
+   * inline, whatever the Workbook's StringMode, because generated
+   * rows are only produced after the shared strings table has been
+   * written.
+   */
+  class SheetRow
+  {
+  public:
+    void add_number_cell(const uint32_t col, const double number, const StyleId style = StyleId()) noexcept(false);
+    void add_formula_cell(const uint32_t col, const std::string &formula, const StyleId style = StyleId()) noexcept(false);
+    void add_string_cell(const uint32_t col, const std::string &value, const StyleId style = StyleId()) noexcept(false);
+    uint32_t get_row(void) const noexcept;
+
+  private:
+    SheetRow(GeneratedSheet &sheet_, OutputBuffer &buffer_, const uint32_t row_) noexcept;
+    void add_cell(const char *caller, const uint32_t col, const CellType type, const StyleId style, const double num_val, const std::string_view text) noexcept(false);
+
+    /**
+     * The sheet being generated and the buffer its .xml is
+     * collected in.
+     */
+    GeneratedSheet &sheet;
+    OutputBuffer &buffer;
+
+    /**
+     * The number of this row and the column of the last cell
+     * added to it, 0 before the first cell.
+     */
+    uint32_t row;
+    uint32_t last_col;
+
+    /**
+     * The number of string cells added to this row, counted in
+     * the Workbook's string statistics once the row is kept.
+     */
+    uint32_t string_cells;
+
+    friend class GeneratedSheet;
+  };
+
+  /**
+   * A row generator is called for rows 1, 2, 3, ... in turn and
+   * adds the cells of the given row to cells. It returns true if
+   * the row belongs to the sheet (a row without cells is simply
+   * left out) and false once there are no more rows, in which case
+   * any cells it added in that call are discarded.
+   */
+  typedef std::function<bool(const uint32_t row, SheetRow &cells)> row_generator_t;
+
+  /**
+   * GeneratedSheet is a sheet whose rows are not stored at all but
+   * pulled from a row generator while publish() writes the sheet's
+   * .xml file, e.g. from a database cursor or a memory mapped file.
+   * The generator is called on the thread that calls publish() and
+   * must keep working until then.
+   *
+   * As with StreamingSheet, columns without a custom width are left
+   * at the default width rather than set to best fit.
+   */
+  class GeneratedSheet
+  {
+  public:
+    void set_column_width(const uint32_t col, const double width) noexcept(false);
+    void set_column_width(const std::string &column, const double width) noexcept(false);
+    void set_row_height(const uint32_t row, const double height) noexcept(false);
+    std::string get_name(void) const noexcept;
+
+  private:
+    GeneratedSheet(const std::string &name_, const std::string &filename_, const row_generator_t &generator_, Workbook &workbook_) noexcept(false);
+    void write_file(void) noexcept(false);
+
+    /**
+     * Reference to the enclosing workbook, used to check styles
+     * and to write to workbook.archive.
+     */
+    Workbook &workbook;
+
+    /**
+     * The name of the GeneratedSheet as displayed on its tab and
+     * the filename of its .xml file in the Workbook ZIP archive.
+     */
+    std::string name;
+    std::string filename;
+
+    /**
+     * Produces the rows of this GeneratedSheet at publish().
+     */
+    row_generator_t generator;
+
+    /**
+     * Custom column widths and row heights.
+     */
+    std::pmr::set<std::pair<uint32_t,double>, column_widths_sort_compare> column_widths;
+    std::pmr::set<std::pair<uint32_t,double>, row_heights_sort_compare> row_heights;
+
+    friend class SheetRow;
+    friend class Workbook;
+  };
+
   class Workbook
   {
   public:
     Workbook(void) noexcept;
+    explicit Workbook(std::pmr::memory_resource *memory_) noexcept;
+    void reset(void) noexcept(false);
     Sheet& addSheet(const std::string &name) noexcept(false);
+    StreamingSheet& addStreamingSheet(const std::string &name) noexcept(false);
+    GeneratedSheet& addGeneratedSheet(const std::string &name, const row_generator_t &generator) noexcept(false);
     size_t addStyle(const cell_style_t &cell_style) noexcept;
+    StyleId registerStyle(const cell_style_t &cell_style) noexcept;
+    void open(const std::string &filename) noexcept(false);
+    void publish(void) noexcept(false);
     void publish(const std::string &filename) noexcept(false);
+    void setThreadCount(const unsigned int count) noexcept;
+    void setCompactOutput(const bool compact) noexcept;
+    void setStringMode(const StringMode mode) noexcept;
+    void setSharedStringThreshold(const double threshold) noexcept(false);
+    string_stats_t getStringStats(void) const noexcept;
 
   private:
+    sheet_info_t nextSheetInfo(const std::string &name) const noexcept(false);
+    void writeSheets(void) noexcept(false);
+    void writeSheetFragments(Sheet &sheet, const size_t num_threads) noexcept(false);
+    void writeSharedStrings(void) noexcept(false);
+    uint32_t internString(const std::string_view value, string_column_stats_t &column_stats) noexcept(false);
+    uint32_t shareString(const uint32_t pool_index) noexcept(false);
+    bool shareColumn(const string_column_stats_t &column_stats) const noexcept;
+    void clearStrings(void) noexcept;
+    uint16_t styleIndex(const StyleId style, const char *caller) const noexcept(false);
+    OutputBuffer takeBuffer(void) noexcept(false);
+    void returnBuffer(OutputBuffer &buffer) noexcept(false);
+    cell_block_t takeBlock(void) noexcept(false);
+    void returnBlocks(std::pmr::vector<cell_block_t> &blocks) noexcept(false);
+
+    /**
+     * A memory resource owned by this Workbook, for Workbooks made
+     * by a WorkbookPool; empty otherwise. Declared first so that it
+     * is destroyed after everything that allocated from it.
+     */
+    std::unique_ptr<std::pmr::memory_resource> owned_memory;
+
+    /**
+     * Where this Workbook and its sheets get their memory: cell
+     * storage, formula and string text, the string pool, style
+     * tables and .xml output buffers. The default resource unless
+     * another is passed to the constructor; it must outlive the
+     * Workbook.
+     */
+    std::pmr::memory_resource *memory;
+
+    /**
+     * The name, filename, sheetId and relId of every Sheet and
+     * StreamingSheet in this Workbook, in the order added.
+     */
+    std::pmr::vector<sheet_info_t> sheet_infos;
+
     /**
      * All of this Workbook's sheets are stored in this vector.
      * This is not a set (which would have faster duplicate name
      * search) because the sheets are stored in the order entered,
      * and this might not be a sorted order.
      */
-    std::vector<Sheet> sheets;
+    std::pmr::vector<Sheet> sheets;
+
+    /**
+     * This Workbook's StreamingSheets. A deque keeps references
+     * returned by addStreamingSheet() valid as more are added.
+     */
+    std::pmr::deque<StreamingSheet> streaming_sheets;
+
+    /**
+     * This Workbook's GeneratedSheets, written by publish() after
+     * all other sheets. A deque keeps references returned by
+     * addGeneratedSheet() valid as more are added.
+     */
+    std::pmr::deque<GeneratedSheet> generated_sheets;
+
+    /**
+     * The StreamingSheet whose file is currently open in the
+     * archive, or nullptr if there is none.
+     */
+    StreamingSheet *streaming_sheet;
+
+    /**
+     * True between open() and the end of publish(), while the
+     * output archive is open.
+     */
+    bool opened;
+
+    /**
+     * Number of threads publish() uses to generate Sheet .xml
+     * files. 0 means one per hardware thread. Set with
+     * setThreadCount(); starts out, and is reset to,
+     * default_thread_count.
+     */
+    unsigned int thread_count;
+
+    /**
+     * The thread count a new or reset Workbook publishes with: 0
+     * when memory is known to be safe to use from several threads
+     * at once (the default resource, or a WorkbookPool's
+     * synchronized pool), 1 for a resource supplied by the caller.
+     */
+    unsigned int default_thread_count;
+
+    /**
+     * True if Sheet .xml files leave out redundant cell references
+     * and default styles. false by default. Set with
+     * setCompactOutput().
+     */
+    bool compact_output;
+
+    /**
+     * How publish() writes the text of Sheet string cells, and
+     * how StreamingSheet string cells are written as they are
+     * added. StringMode::INLINE by default. Set with
+     * setStringMode().
+     */
+    StringMode string_mode;
+
+    /**
+     * Share of repeated values at or above which a column is
+     * written to the shared strings table in StringMode::ADAPTIVE.
+     * Set with setSharedStringThreshold().
+     */
+    double shared_string_threshold;
+
+    /**
+     * The workbook-wide string pool. Every distinct string cell
+     * value is stored once, in string_text; string_pool lists
+     * those strings in order of first use and string_indices maps
+     * each one to its position in string_pool. Sheet string cells
+     * always refer to this pool; StreamingSheet string cells only
+     * do so in StringMode::SHARED and StringMode::ADAPTIVE.
+     */
+    TextArena string_text;
+    std::pmr::unordered_map<std::string_view, uint32_t> string_indices;
+    std::pmr::vector<std::string_view> string_pool;
+
+    /**
+     * The contents of xl/sharedStrings.xml: shared_strings holds
+     * the string_pool positions of the strings written to it, in
+     * order, and shared_string_positions maps each string_pool
+     * position to its place in shared_strings, or NOT_SHARED.
+     * Filled as shared cells are written by StreamingSheets and
+     * by share_strings() at publish().
+     */
+    std::pmr::vector<uint32_t> shared_strings;
+    std::pmr::vector<uint32_t> shared_string_positions;
+
+    /**
+     * Counts for the Workbook being built and for the one last
+     * published, which getStringStats() returns.
+     */
+    string_stats_t string_stats;
+    string_stats_t published_string_stats;
 
     /**
      * The various cell styles actually in use are stored in
      * this array so that the styles.xml file only needs to define
      * styles that are really used in this workbook.
      */
-    std::vector<cell_style_t> cell_styles;
+    std::pmr::vector<cell_style_t> cell_styles;
+
+    /**
+     * Maps the packed key of each style in cell_styles (see
+     * style_key() in BasicWorkbook.cpp) to its index there, so
+     * that addStyle() finds a style in constant time. The key and
+     * index of the last style looked up are kept as well.
+     */
+    std::pmr::unordered_map<uint32_t, size_t> style_indices;
+    uint32_t last_style_key;
+    size_t last_style_index;
 
     /**
      * All Office Open XML files are stored in ZIP archives as the
@@ -392,6 +1052,65 @@ namespace BasicWorkbook
      * ZIP archive file on disk.
      */
     IttyZip::IttyZip archive;
+
+    /**
+     * Emptied OutputBuffers kept for the next sheet file or
+     * fragment, so their capacity is reused from sheet to sheet
+     * and from one publish() to the next. Guarded by
+     * spare_buffers_mutex, as worker threads take and return
+     * buffers while publish() runs.
+     */
+    std::pmr::vector<OutputBuffer> spare_buffers;
+    std::mutex spare_buffers_mutex;
+
+    /**
+     * Emptied cell blocks of published or discarded Sheets, kept
+     * with the capacity of their arrays for the blocks of later
+     * Sheets. Guarded by spare_blocks_mutex, as worker threads
+     * return the blocks of the Sheets they have written.
+     */
+    std::pmr::vector<cell_block_t> spare_blocks;
+    std::mutex spare_blocks_mutex;
+
+    friend class Sheet;
+    friend class StreamingSheet;
+    friend class SheetRow;
+    friend class GeneratedSheet;
+    friend class WorkbookPool;
+  };
+
+  /**
+   * A thread-safe pool of Workbooks for services that build many
+   * workbooks one after another. acquire() hands out an idle
+   * Workbook, or a new one if there is none, and release() resets
+   * a Workbook (see Workbook::reset()) and keeps it for the next
+   * acquire(), along with the memory it has already allocated.
+   * Each pooled Workbook takes its memory from a
+   * std::pmr::synchronized_pool_resource of its own, which also
+   * recycles the small allocations of sets and maps, so a pooled
+   * Workbook that builds reports of a similar size settles into
+   * reusing its memory rather than allocating more. Being
+   * thread-safe, that resource lets a pooled Workbook publish with
+   * one thread per hardware thread, like a default constructed one.
+   */
+  class WorkbookPool
+  {
+  public:
+    WorkbookPool(void) noexcept(false);
+    explicit WorkbookPool(const size_t max_idle_) noexcept(false);
+    std::unique_ptr<Workbook> acquire(void) noexcept(false);
+    void release(std::unique_ptr<Workbook> workbook) noexcept(false);
+    size_t idleCount(void) const noexcept;
+
+  private:
+    /**
+     * Workbooks released and waiting to be acquired again, at
+     * most max_idle of them; any further Workbook released is
+     * destroyed instead. Guarded by idle_mutex.
+     */
+    std::vector<std::unique_ptr<Workbook> > idle;
+    size_t max_idle;
+    mutable std::mutex idle_mutex;
   };
 }
 
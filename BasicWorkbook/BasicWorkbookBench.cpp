@@ -0,0 +1,778 @@
+/**
+ * BasicWorkbookBench.cpp
+ *
+ * Microbenchmarks for BasicWorkbook. Times cell reference formatting,
+ * cell style lookup and insertion, and the serialization of a whole
+ * numeric sheet, and prints the results as JSON on stdout so that runs
+ * from different commits on the same machine can be compared directly.
+ *
+ * Usage: BasicWorkbookBench [--reps n] [--rows n] [--cols n]
+ *                           [--threads n]
+ *
+ * Written in 2019 by Ben Tesch.
+ * Originally distributed at https://github.com/slugrustle/office_open_xml
+ * 
+ * To the extent possible under law, the author has dedicated all copyright
+ * and related and neighboring rights to this software to the public domain
+ * worldwide. This software is distributed without any warranty.
+ * The text of the CC0 Public Domain Dedication should be reproduced at the
+ * end of this file. If not, see http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "BasicWorkbook.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <exception>
+
+#ifdef _WIN32
+static const char NULL_SINK[] = "NUL";
+#else
+static const char NULL_SINK[] = "/dev/null";
+#endif
+
+/**
+ * Settings that may be overridden on the command line.
+ */
+typedef struct
+{
+  uint32_t reps;
+  uint32_t rows;
+  uint32_t cols;
+  uint32_t threads;
+} bench_config_t;
+
+/**
+ * Result of a single benchmark. seconds is the best (smallest)
+ * time over all repetitions; items is the number of operations
+ * (references formatted, cells written) per repetition.
+ */
+typedef struct
+{
+  const char *name;
+  uint64_t items;
+  double seconds;
+} bench_result_t;
+
+/**
+ * Folded into by every benchmark so that the compiler cannot
+ * discard the work being timed.
+ */
+static volatile size_t sink_total = 0u;
+
+/**
+ * The column naming loop BasicWorkbook used before the column
+ * name table, kept as a baseline.
+ */
+static std::string legacy_integer_to_column(uint32_t integer)
+{
+  std::string column;
+
+  while (integer > 0u)
+  {
+    uint32_t remainder = integer % 26u;
+    integer--;
+    integer /= 26u;
+
+    if (remainder == 0u)
+    {
+      column.insert(0u, 1u, 'Z');
+    }
+    else
+    {
+      column.insert(0u, 1u, static_cast<char>(remainder + 64u));
+    }
+  }
+
+  return column;
+}
+
+/**
+ * Each of these formats the reference of every cell in a rows x
+ * cols sheet and returns the number of references formatted.
+ */
+static uint64_t bench_legacy_mixedref(const bench_config_t &config) noexcept(false)
+{
+  size_t total = 0u;
+  for (uint32_t jRow = 1u; jRow <= config.rows; jRow++)
+  {
+    for (uint32_t jCol = 1u; jCol <= config.cols; jCol++)
+    {
+      total += (legacy_integer_to_column(jCol) + std::to_string(jRow)).size();
+    }
+  }
+  sink_total += total;
+  return static_cast<uint64_t>(config.rows) * config.cols;
+}
+
+static uint64_t bench_integerref_to_mixedref(const bench_config_t &config) noexcept(false)
+{
+  size_t total = 0u;
+  for (uint32_t jRow = 1u; jRow <= config.rows; jRow++)
+  {
+    for (uint32_t jCol = 1u; jCol <= config.cols; jCol++)
+    {
+      total += BasicWorkbook::integerref_to_mixedref(jRow, jCol).size();
+    }
+  }
+  sink_total += total;
+  return static_cast<uint64_t>(config.rows) * config.cols;
+}
+
+static uint64_t bench_write_mixedref(const bench_config_t &config) noexcept(false)
+{
+  char mixedref[BasicWorkbook::MAX_MIXEDREF_LEN];
+  size_t total = 0u;
+  for (uint32_t jRow = 1u; jRow <= config.rows; jRow++)
+  {
+    for (uint32_t jCol = 1u; jCol <= config.cols; jCol++)
+    {
+      total += BasicWorkbook::write_mixedref(mixedref, jRow, jCol);
+    }
+  }
+  sink_total += total;
+  return static_cast<uint64_t>(config.rows) * config.cols;
+}
+
+/**
+ * Names every column 16 times over through integer_to_column().
+ */
+static uint64_t bench_all_columns(const bench_config_t &config) noexcept(false)
+{
+  size_t total = 0u;
+  for (uint32_t jRep = 0u; jRep < 16u; jRep++)
+  {
+    for (uint32_t jCol = 1u; jCol <= BasicWorkbook::MAX_COL; jCol++)
+    {
+      total += BasicWorkbook::integer_to_column(jCol).size();
+    }
+  }
+  sink_total += total;
+  (void)config;
+  return 16u * static_cast<uint64_t>(BasicWorkbook::MAX_COL);
+}
+
+/**
+ * Builds a rows x cols sheet of numbers and publishes it to the
+ * null sink, with or without compact output. Only publish() is
+ * meant to dominate, but building the sheet is included since the
+ * two are hard to separate.
+ */
+static uint64_t publish_numbers(const bench_config_t &config, const bool compact) noexcept(false)
+{
+  BasicWorkbook::Workbook workbook;
+  workbook.setThreadCount(config.threads);
+  workbook.setCompactOutput(compact);
+  BasicWorkbook::Sheet &sheet = workbook.addSheet("bench");
+  for (uint32_t jRow = 1u; jRow <= config.rows; jRow++)
+  {
+    for (uint32_t jCol = 1u; jCol <= config.cols; jCol++)
+    {
+      sheet.add_number_cell(jRow, jCol, static_cast<double>(jRow) * 0.25 + jCol);
+    }
+  }
+  workbook.publish(NULL_SINK);
+  return static_cast<uint64_t>(config.rows) * config.cols;
+}
+
+static uint64_t bench_publish_numbers(const bench_config_t &config) noexcept(false)
+{
+  return publish_numbers(config, false);
+}
+
+static uint64_t bench_publish_numbers_compact(const bench_config_t &config) noexcept(false)
+{
+  return publish_numbers(config, true);
+}
+
+/**
+ * Publishes the same numbers as publish_numbers from a
+ * GeneratedSheet, which produces each row while it is written
+ * instead of storing the cells first.
+ */
+static uint64_t bench_publish_generated(const bench_config_t &config) noexcept(false)
+{
+  BasicWorkbook::Workbook workbook;
+  workbook.setThreadCount(config.threads);
+  workbook.addGeneratedSheet("bench",
+    [&](const uint32_t row, BasicWorkbook::SheetRow &cells)
+    {
+      if (row > config.rows)
+      {
+        return false;
+      }
+      for (uint32_t jCol = 1u; jCol <= config.cols; jCol++)
+      {
+        cells.add_number_cell(jCol, static_cast<double>(row) * 0.25 + jCol);
+      }
+      return true;
+    });
+  workbook.publish(NULL_SINK);
+  return static_cast<uint64_t>(config.rows) * config.cols;
+}
+
+/**
+ * The report benchmarks publish the cells of publish_numbers as
+ * this many small workbooks, each with an equal share of the rows.
+ */
+static const uint32_t REPORT_BENCH_REPORTS = 100u;
+
+/**
+ * Publishes REPORT_BENCH_REPORTS small workbooks of numbers, each
+ * built in a newly constructed Workbook or, if pool is not null,
+ * in one acquired from pool and released again afterwards.
+ */
+static uint64_t publish_reports(const bench_config_t &config, BasicWorkbook::WorkbookPool *pool) noexcept(false)
+{
+  const uint32_t report_rows = std::max(config.rows / REPORT_BENCH_REPORTS, 1u);
+  for (uint32_t jReport = 0u; jReport < REPORT_BENCH_REPORTS; jReport++)
+  {
+    std::unique_ptr<BasicWorkbook::Workbook> workbook(pool != nullptr ? pool->acquire() : std::unique_ptr<BasicWorkbook::Workbook>(new BasicWorkbook::Workbook()));
+    workbook->setThreadCount(config.threads);
+    BasicWorkbook::Sheet &sheet = workbook->addSheet("bench");
+    for (uint32_t jRow = 1u; jRow <= report_rows; jRow++)
+    {
+      for (uint32_t jCol = 1u; jCol <= config.cols; jCol++)
+      {
+        sheet.add_number_cell(jRow, jCol, static_cast<double>(jRow) * 0.25 + jCol);
+      }
+    }
+    workbook->publish(NULL_SINK);
+    if (pool != nullptr)
+    {
+      pool->release(std::move(workbook));
+    }
+  }
+  return static_cast<uint64_t>(report_rows) * config.cols * REPORT_BENCH_REPORTS;
+}
+
+static uint64_t bench_publish_reports(const bench_config_t &config) noexcept(false)
+{
+  return publish_reports(config, nullptr);
+}
+
+static uint64_t bench_publish_reports_pooled(const bench_config_t &config) noexcept(false)
+{
+  BasicWorkbook::WorkbookPool pool(1u);
+  return publish_reports(config, &pool);
+}
+
+/**
+ * The style benchmarks look up or insert STYLE_BENCH_CELLS cells,
+ * cycling through STYLE_BENCH_STYLES distinct styles.
+ */
+static const uint32_t STYLE_BENCH_CELLS = 10000000u;
+static const uint32_t STYLE_BENCH_STYLES = 500u;
+
+/**
+ * Returns STYLE_BENCH_STYLES distinct cell styles.
+ */
+static std::vector<BasicWorkbook::cell_style_t> make_styles(void) noexcept(false)
+{
+  std::vector<BasicWorkbook::NumberFormat> formats;
+  formats.push_back(BasicWorkbook::NumberFormat::GENERAL);
+  formats.push_back(BasicWorkbook::NumberFormat::TEXT);
+  for (uint8_t jFormat = static_cast<uint8_t>(BasicWorkbook::NumberFormat::FIX0);
+       jFormat <= static_cast<uint8_t>(BasicWorkbook::NumberFormat::PCT16);
+       jFormat++)
+  {
+    formats.push_back(static_cast<BasicWorkbook::NumberFormat>(jFormat));
+  }
+
+  std::vector<BasicWorkbook::cell_style_t> styles;
+  for (uint32_t jStyle = 0u; jStyle < STYLE_BENCH_STYLES; jStyle++)
+  {
+    BasicWorkbook::cell_style_t style;
+    style.num_format = formats.at(jStyle % formats.size());
+    style.horiz_align = static_cast<BasicWorkbook::HorizontalAlignment>((jStyle / formats.size()) % 4u);
+    style.vert_align = static_cast<BasicWorkbook::VerticalAlignment>((jStyle / (formats.size() * 4u)) % 3u);
+    style.wrap_text = ((jStyle / (formats.size() * 12u)) % 2u) != 0u;
+    style.bold = false;
+    styles.push_back(style);
+  }
+  return styles;
+}
+
+/**
+ * The linear search Workbook::addStyle() used before the style
+ * hash map, kept as a baseline.
+ */
+static uint64_t bench_style_find_legacy(const bench_config_t &config) noexcept(false)
+{
+  std::vector<BasicWorkbook::cell_style_t> styles = make_styles();
+  std::vector<BasicWorkbook::cell_style_t> cell_styles;
+  size_t total = 0u;
+  for (uint32_t jCell = 0u; jCell < STYLE_BENCH_CELLS; jCell++)
+  {
+    const BasicWorkbook::cell_style_t &style = styles[jCell % STYLE_BENCH_STYLES];
+    std::vector<BasicWorkbook::cell_style_t>::iterator itr = std::find_if(cell_styles.begin(), cell_styles.end(),
+      [&style](const BasicWorkbook::cell_style_t &other)
+      {
+        return other.num_format == style.num_format && other.horiz_align == style.horiz_align &&
+               other.vert_align == style.vert_align && other.wrap_text == style.wrap_text &&
+               other.bold == style.bold;
+      });
+    if (itr == cell_styles.end())
+    {
+      cell_styles.push_back(style);
+      total += cell_styles.size() - 1u;
+    }
+    else
+    {
+      total += static_cast<size_t>(itr - cell_styles.begin());
+    }
+  }
+  sink_total += total;
+  (void)config;
+  return STYLE_BENCH_CELLS;
+}
+
+static uint64_t bench_add_style(const bench_config_t &config) noexcept(false)
+{
+  std::vector<BasicWorkbook::cell_style_t> styles = make_styles();
+  BasicWorkbook::Workbook workbook;
+  size_t total = 0u;
+  for (uint32_t jCell = 0u; jCell < STYLE_BENCH_CELLS; jCell++)
+  {
+    total += workbook.addStyle(styles[jCell % STYLE_BENCH_STYLES]);
+  }
+  sink_total += total;
+  (void)config;
+  return STYLE_BENCH_CELLS;
+}
+
+/**
+ * Adds STYLE_BENCH_CELLS number cells, 10 to a row, to a Sheet.
+ */
+static uint64_t bench_insert_styled_cells(const bench_config_t &config) noexcept(false)
+{
+  std::vector<BasicWorkbook::cell_style_t> styles = make_styles();
+  BasicWorkbook::Workbook workbook;
+  BasicWorkbook::Sheet &sheet = workbook.addSheet("bench");
+  for (uint32_t jCell = 0u; jCell < STYLE_BENCH_CELLS; jCell++)
+  {
+    sheet.add_number_cell(jCell / 10u + 1u, jCell % 10u + 1u, static_cast<double>(jCell), styles[jCell % STYLE_BENCH_STYLES]);
+  }
+  (void)config;
+  return STYLE_BENCH_CELLS;
+}
+
+/**
+ * As bench_insert_styled_cells(), with the styles registered
+ * up front and cells added by StyleId.
+ */
+static uint64_t bench_insert_registered_cells(const bench_config_t &config) noexcept(false)
+{
+  std::vector<BasicWorkbook::cell_style_t> styles = make_styles();
+  BasicWorkbook::Workbook workbook;
+  std::vector<BasicWorkbook::StyleId> style_ids;
+  for (size_t jStyle = 0u; jStyle < styles.size(); jStyle++)
+  {
+    style_ids.push_back(workbook.registerStyle(styles[jStyle]));
+  }
+
+  BasicWorkbook::Sheet &sheet = workbook.addSheet("bench");
+  for (uint32_t jCell = 0u; jCell < STYLE_BENCH_CELLS; jCell++)
+  {
+    sheet.add_number_cell(jCell / 10u + 1u, jCell % 10u + 1u, static_cast<double>(jCell), style_ids[jCell % STYLE_BENCH_STYLES]);
+  }
+  (void)config;
+  return STYLE_BENCH_CELLS;
+}
+
+/**
+ * Each of these adds a rows x cols sheet of numbers with a
+ * registered style, cell by cell, a row at a time with add_row()
+ * or in one add_block() call.
+ */
+static uint64_t bench_add_cells(const bench_config_t &config) noexcept(false)
+{
+  BasicWorkbook::Workbook workbook;
+  BasicWorkbook::StyleId style = workbook.registerStyle(BasicWorkbook::generic_style);
+  BasicWorkbook::Sheet &sheet = workbook.addSheet("bench");
+  for (uint32_t jRow = 1u; jRow <= config.rows; jRow++)
+  {
+    for (uint32_t jCol = 1u; jCol <= config.cols; jCol++)
+    {
+      sheet.add_number_cell(jRow, jCol, static_cast<double>(jRow) * 0.25 + jCol, style);
+    }
+  }
+  return static_cast<uint64_t>(config.rows) * config.cols;
+}
+
+static uint64_t bench_add_rows(const bench_config_t &config) noexcept(false)
+{
+  BasicWorkbook::Workbook workbook;
+  BasicWorkbook::StyleId style = workbook.registerStyle(BasicWorkbook::generic_style);
+  BasicWorkbook::Sheet &sheet = workbook.addSheet("bench");
+  std::vector<double> values(config.cols);
+  for (uint32_t jRow = 1u; jRow <= config.rows; jRow++)
+  {
+    for (uint32_t jCol = 1u; jCol <= config.cols; jCol++)
+    {
+      values[jCol - 1u] = static_cast<double>(jRow) * 0.25 + jCol;
+    }
+    sheet.add_row(jRow, 1u, values.data(), values.size(), style);
+  }
+  return static_cast<uint64_t>(config.rows) * config.cols;
+}
+
+static uint64_t bench_add_block(const bench_config_t &config) noexcept(false)
+{
+  BasicWorkbook::Workbook workbook;
+  BasicWorkbook::StyleId style = workbook.registerStyle(BasicWorkbook::generic_style);
+  BasicWorkbook::Sheet &sheet = workbook.addSheet("bench");
+  std::vector<double> values(static_cast<size_t>(config.rows) * config.cols);
+  for (uint32_t jRow = 1u; jRow <= config.rows; jRow++)
+  {
+    for (uint32_t jCol = 1u; jCol <= config.cols; jCol++)
+    {
+      values[static_cast<size_t>(jRow - 1u) * config.cols + jCol - 1u] = static_cast<double>(jRow) * 0.25 + jCol;
+    }
+  }
+  sheet.add_block(1u, 1u, config.rows, config.cols, values.data(), config.cols, style);
+  return static_cast<uint64_t>(config.rows) * config.cols;
+}
+
+/**
+ * Each of these adds a rows x cols sheet of numbers held in
+ * column-major order: cell by cell going down each column, by
+ * copying it to row-major order for add_block(), or with
+ * add_columns(). Filling the columns is not timed separately.
+ */
+static std::vector<std::vector<double> > make_columns(const bench_config_t &config) noexcept(false)
+{
+  std::vector<std::vector<double> > columns(config.cols, std::vector<double>(config.rows));
+  for (uint32_t jCol = 0u; jCol < config.cols; jCol++)
+  {
+    for (uint32_t jRow = 0u; jRow < config.rows; jRow++)
+    {
+      columns[jCol][jRow] = static_cast<double>(jRow + 1u) * 0.25 + jCol + 1u;
+    }
+  }
+  return columns;
+}
+
+static uint64_t bench_add_cells_by_column(const bench_config_t &config) noexcept(false)
+{
+  std::vector<std::vector<double> > columns = make_columns(config);
+  BasicWorkbook::Workbook workbook;
+  BasicWorkbook::StyleId style = workbook.registerStyle(BasicWorkbook::generic_style);
+  BasicWorkbook::Sheet &sheet = workbook.addSheet("bench");
+  for (uint32_t jCol = 0u; jCol < config.cols; jCol++)
+  {
+    for (uint32_t jRow = 0u; jRow < config.rows; jRow++)
+    {
+      sheet.add_number_cell(jRow + 1u, jCol + 1u, columns[jCol][jRow], style);
+    }
+  }
+  return static_cast<uint64_t>(config.rows) * config.cols;
+}
+
+static uint64_t bench_add_block_transposed(const bench_config_t &config) noexcept(false)
+{
+  std::vector<std::vector<double> > columns = make_columns(config);
+  BasicWorkbook::Workbook workbook;
+  BasicWorkbook::StyleId style = workbook.registerStyle(BasicWorkbook::generic_style);
+  BasicWorkbook::Sheet &sheet = workbook.addSheet("bench");
+  std::vector<double> values(static_cast<size_t>(config.rows) * config.cols);
+  for (uint32_t jCol = 0u; jCol < config.cols; jCol++)
+  {
+    for (uint32_t jRow = 0u; jRow < config.rows; jRow++)
+    {
+      values[static_cast<size_t>(jRow) * config.cols + jCol] = columns[jCol][jRow];
+    }
+  }
+  sheet.add_block(1u, 1u, config.rows, config.cols, values.data(), config.cols, style);
+  return static_cast<uint64_t>(config.rows) * config.cols;
+}
+
+static uint64_t bench_add_columns(const bench_config_t &config) noexcept(false)
+{
+  std::vector<std::vector<double> > columns = make_columns(config);
+  BasicWorkbook::Workbook workbook;
+  BasicWorkbook::StyleId style = workbook.registerStyle(BasicWorkbook::generic_style);
+  BasicWorkbook::Sheet &sheet = workbook.addSheet("bench");
+  std::vector<const double*> column_ptrs;
+  for (uint32_t jCol = 0u; jCol < config.cols; jCol++)
+  {
+    column_ptrs.push_back(columns[jCol].data());
+  }
+  sheet.add_columns(1u, 1u, config.rows, config.cols, column_ptrs.data(), style);
+  return static_cast<uint64_t>(config.rows) * config.cols;
+}
+
+/**
+ * The benchmarks, run in this order.
+ */
+typedef struct
+{
+  const char *name;
+  uint64_t (*run)(const bench_config_t &config);
+} bench_case_t;
+
+static const bench_case_t BENCH_CASES[] =
+{
+  {"mixedref_legacy", bench_legacy_mixedref},
+  {"integerref_to_mixedref", bench_integerref_to_mixedref},
+  {"write_mixedref", bench_write_mixedref},
+  {"integer_to_column_all", bench_all_columns},
+  {"publish_numbers", bench_publish_numbers},
+  {"publish_numbers_compact", bench_publish_numbers_compact},
+  {"publish_generated", bench_publish_generated},
+  {"publish_reports", bench_publish_reports},
+  {"publish_reports_pooled", bench_publish_reports_pooled},
+  {"style_find_legacy", bench_style_find_legacy},
+  {"add_style", bench_add_style},
+  {"insert_styled_cells", bench_insert_styled_cells},
+  {"insert_registered_cells", bench_insert_registered_cells},
+  {"add_cells", bench_add_cells},
+  {"add_rows", bench_add_rows},
+  {"add_block", bench_add_block},
+  {"add_cells_by_column", bench_add_cells_by_column},
+  {"add_block_transposed", bench_add_block_transposed},
+  {"add_columns", bench_add_columns}
+};
+
+/**
+ * Parses a positive integer command line value.
+ */
+static bool parse_u32(const char *text, uint32_t &value) noexcept
+{
+  char *end = nullptr;
+  unsigned long parsed = std::strtoul(text, &end, 10);
+  if (end == text || *end != '\0' || parsed == 0u || parsed > 0xFFFFFFFFu)
+  {
+    return false;
+  }
+  value = static_cast<uint32_t>(parsed);
+  return true;
+}
+
+static bool parse_args(int argc, char **argv, bench_config_t &config) noexcept
+{
+  for (int jArg = 1; jArg < argc; jArg++)
+  {
+    if (jArg + 1 >= argc)
+    {
+      return false;
+    }
+
+    const char *option = argv[jArg];
+    uint32_t number = 0u;
+    if (!parse_u32(argv[++jArg], number))
+    {
+      return false;
+    }
+    else if (std::strcmp(option, "--reps") == 0)
+    {
+      config.reps = number;
+    }
+    else if (std::strcmp(option, "--rows") == 0 && number <= BasicWorkbook::MAX_ROW)
+    {
+      config.rows = number;
+    }
+    else if (std::strcmp(option, "--cols") == 0 && number <= BasicWorkbook::MAX_COL)
+    {
+      config.cols = number;
+    }
+    else if (std::strcmp(option, "--threads") == 0)
+    {
+      config.threads = number;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  bench_config_t config;
+  config.reps = 5u;
+  config.rows = 100000u;
+  config.cols = 10u;
+  config.threads = 1u;
+
+  if (!parse_args(argc, argv, config))
+  {
+    std::fprintf(stderr, "Usage: %s [--reps n] [--rows n] [--cols n] [--threads n]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<bench_result_t> results;
+  try
+  {
+    for (const bench_case_t &bench_case : BENCH_CASES)
+    {
+      bench_result_t result;
+      result.name = bench_case.name;
+      result.items = 0u;
+      result.seconds = 0.0;
+
+      for (uint32_t jRep = 0u; jRep < config.reps; jRep++)
+      {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        result.items = bench_case.run(config);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (jRep == 0u || seconds < result.seconds)
+        {
+          result.seconds = seconds;
+        }
+      }
+
+      std::fprintf(stderr, "%s items=%llu %.6f s\n", result.name,
+                   static_cast<unsigned long long>(result.items), result.seconds);
+      results.push_back(result);
+    }
+  }
+  catch (std::exception &e)
+  {
+    std::fprintf(stderr, "Benchmark failed.\n%s\n\n", e.what());
+    return EXIT_FAILURE;
+  }
+
+  std::printf("{\n  \"benchmark\": \"BasicWorkbook\",\n  \"reps\": %u,\n  \"rows\": %u,\n  \"cols\": %u,\n  \"threads\": %u,\n  \"results\": [",
+              config.reps, config.rows, config.cols, config.threads);
+  for (size_t jResult = 0u; jResult < results.size(); jResult++)
+  {
+    const bench_result_t &result = results.at(jResult);
+    double seconds = (result.seconds > 0.0 ? result.seconds : 1.0e-9);
+    std::printf("%s\n    {\"name\": \"%s\", \"items\": %llu, \"seconds\": %.9f, \"items_per_sec\": %.3f}",
+                (jResult == 0u ? "" : ","), result.name, static_cast<unsigned long long>(result.items),
+                result.seconds, static_cast<double>(result.items) / seconds);
+  }
+  std::printf("\n  ]\n}\n");
+
+  return EXIT_SUCCESS;
+}
+
+/*
+Creative Commons Legal Code
+
+CC0 1.0 Universal
+
+    CREATIVE COMMONS CORPORATION IS NOT A LAW FIRM AND DOES NOT PROVIDE
+    LEGAL SERVICES. DISTRIBUTION OF THIS DOCUMENT DOES NOT CREATE AN
+    ATTORNEY-CLIENT RELATIONSHIP. CREATIVE COMMONS PROVIDES THIS
+    INFORMATION ON AN "AS-IS" BASIS. CREATIVE COMMONS MAKES NO WARRANTIES
+    REGARDING THE USE OF THIS DOCUMENT OR THE INFORMATION OR WORKS
+    PROVIDED HEREUNDER, AND DISCLAIMS LIABILITY FOR DAMAGES RESULTING FROM
+    THE USE OF THIS DOCUMENT OR THE INFORMATION OR WORKS PROVIDED
+    HEREUNDER.
+
+Statement of Purpose
+
+The laws of most jurisdictions throughout the world automatically confer
+exclusive Copyright and Related Rights (defined below) upon the creator
+and subsequent owner(s) (each and all, an "owner") of an original work of
+authorship and/or a database (each, a "Work").
+
+Certain owners wish to permanently relinquish those rights to a Work for
+the purpose of contributing to a commons of creative, cultural and
+scientific works ("Commons") that the public can reliably and without fear
+of later claims of infringement build upon, modify, incorporate in other
+works, reuse and redistribute as freely as possible in any form whatsoever
+and for any purposes, including without limitation commercial purposes.
+These owners may contribute to the Commons to promote the ideal of a free
+culture and the further production of creative, cultural and scientific
+works, or to gain reputation or greater distribution for their Work in
+part through the use and efforts of others.
+
+For these and/or other purposes and motivations, and without any
+expectation of additional consideration or compensation, the person
+associating CC0 with a Work (the "Affirmer"), to the extent that he or she
+is an owner of Copyright and Related Rights in the Work, voluntarily
+elects to apply CC0 to the Work and publicly distribute the Work under its
+terms, with knowledge of his or her Copyright and Related Rights in the
+Work and the meaning and intended legal effect of CC0 on those rights.
+
+1. Copyright and Related Rights. A Work made available under CC0 may be
+protected by copyright and related or neighboring rights ("Copyright and
+Related Rights"). Copyright and Related Rights include, but are not
+limited to, the following:
+
+  i. the right to reproduce, adapt, distribute, perform, display,
+     communicate, and translate a Work;
+ ii. moral rights retained by the original author(s) and/or performer(s);
+iii. publicity and privacy rights pertaining to a person's image or
+     likeness depicted in a Work;
+ iv. rights protecting against unfair competition in regards to a Work,
+     subject to the limitations in paragraph 4(a), below;
+  v. rights protecting the extraction, dissemination, use and reuse of data
+     in a Work;
+ vi. database rights (such as those arising under Directive 96/9/EC of the
+     European Parliament and of the Council of 11 March 1996 on the legal
+     protection of databases, and under any national implementation
+     thereof, including any amended or successor version of such
+     directive); and
+vii. other similar, equivalent or corresponding rights throughout the
+     world based on applicable law or treaty, and any national
+     implementations thereof.
+
+2. Waiver. To the greatest extent permitted by, but not in contravention
+of, applicable law, Affirmer hereby overtly, fully, permanently,
+irrevocably and unconditionally waives, abandons, and surrenders all of
+Affirmer's Copyright and Related Rights and associated claims and causes
+of action, whether now known or unknown (including existing as well as
+future claims and causes of action), in the Work (i) in all territories
+worldwide, (ii) for the maximum duration provided by applicable law or
+treaty (including future time extensions), (iii) in any current or future
+medium and for any number of copies, and (iv) for any purpose whatsoever,
+including without limitation commercial, advertising or promotional
+purposes (the "Waiver"). Affirmer makes the Waiver for the benefit of each
+member of the public at large and to the detriment of Affirmer's heirs and
+successors, fully intending that such Waiver shall not be subject to
+revocation, rescission, cancellation, termination, or any other legal or
+equitable action to disrupt the quiet enjoyment of the Work by the public
+as contemplated by Affirmer's express Statement of Purpose.
+
+3. Public License Fallback. Should any part of the Waiver for any reason
+be judged legally invalid or ineffective under applicable law, then the
+Waiver shall be preserved to the maximum extent permitted taking into
+account Affirmer's express Statement of Purpose. In addition, to the
+extent the Waiver is so judged Affirmer hereby grants to each affected
+person a royalty-free, non transferable, non sublicensable, non exclusive,
+irrevocable and unconditional license to exercise Affirmer's Copyright and
+Related Rights in the Work (i) in all territories worldwide, (ii) for the
+maximum duration provided by applicable law or treaty (including future
+time extensions), (iii) in any current or future medium and for any number
+of copies, and (iv) for any purpose whatsoever, including without
+limitation commercial, advertising or promotional purposes (the
+"License"). The License shall be deemed effective as of the date CC0 was
+applied by Affirmer to the Work. Should any part of the License for any
+reason be judged legally invalid or ineffective under applicable law, such
+partial invalidity or ineffectiveness shall not invalidate the remainder
+of the License, and in such case Affirmer hereby affirms that he or she
+will not (i) exercise any of his or her remaining Copyright and Related
+Rights in the Work or (ii) assert any associated claims and causes of
+action with respect to the Work, in either case contrary to Affirmer's
+express Statement of Purpose.
+
+4. Limitations and Disclaimers.
+
+ a. No trademark or patent rights held by Affirmer are waived, abandoned,
+    surrendered, licensed or otherwise affected by this document.
+ b. Affirmer offers the Work as-is and makes no representations or
+    warranties of any kind concerning the Work, express, implied,
+    statutory or otherwise, including without limitation warranties of
+    title, merchantability, fitness for a particular purpose, non
+    infringement, or the absence of latent or other defects, accuracy, or
+    the present or absence of errors, whether or not discoverable, all to
+    the greatest extent permissible under applicable law.
+ c. Affirmer disclaims responsibility for clearing rights of other persons
+    that may apply to the Work or any use thereof, including without
+    limitation any person's Copyright and Related Rights in the Work.
+    Further, Affirmer disclaims responsibility for obtaining any necessary
+    consents, permissions or other rights required for any use of the
+    Work.
+ d. Affirmer understands and acknowledges that Creative Commons is not a
+    party to this document and has no duty or obligation with respect to
+    this CC0 or use of the Work.
+*/
@@ -26,9 +26,43 @@
 namespace IttyZip
 {
 
+  /**
+   * Header field values shared by every file IttyZip writes.
+   * See generateHeaders() for the reasoning behind each one.
+   */
+  static const uint16_t ZIP_VERSION = 0x000Au;
+  static const uint16_t ZIP_BIT_FLAG = 0u;
+  static const uint16_t ZIP_METHOD_STORE = 0u;
+
   /* mutex used by localtime_locked and gmtime_locked */
   static std::mutex time_mutex;
 
+  /**
+   * 64 bit FNV-1a hash of filename, which identifies filenames
+   * for duplicate detection once the central directory spills.
+   */
+  static uint64_t filename_hash(const std::string &filename) noexcept
+  {
+    uint64_t hash = 0xCBF29CE484222325u;
+    for (size_t jChar = 0u; jChar < filename.size(); jChar++)
+    {
+      hash ^= static_cast<uint8_t>(filename[jChar]);
+      hash *= 0x00000100000001B3u;
+    }
+    return hash;
+  }
+
+#ifdef ITTYZIP_STATS
+  /**
+   * Nanoseconds elapsed since start. Only used to collect
+   * the counters returned by IttyZip::getStats().
+   */
+  static uint64_t nanoseconds_since(const std::chrono::steady_clock::time_point &start) noexcept
+  {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+  }
+#endif
+
   /**
    * localtime is not thread safe, and neither localtime_s nor localtime_r
    * is portable. Recommend using localtime_locked everywhere (or an
@@ -85,6 +119,17 @@ namespace IttyZip
    * the input string data.
    */
   uint32_t crc32(const std::string &data) noexcept
+  {
+    return crc32(0u, data.c_str(), data.size());
+  }
+
+  /**
+   * Continues the CRC-32 checksum crc over another length bytes
+   * of data. Start with crc = 0 for the first block; the return
+   * value is the checksum of all the data seen so far, so blocks
+   * of a large file can be checksummed one after another.
+   */
+  uint32_t crc32(const uint32_t crc, const char *data, const size_t length) noexcept
   {
     static const uint32_t crc32_table[256] = {0x00000000u, 0x77073096u, 0xEE0E612Cu, 0x990951BAu, 0x076DC419u, 0x706AF48Fu, 0xE963A535u, 0x9E6495A3u, 0x0EDB8832u, 0x79DCB8A4u, 0xE0D5E91Eu, 
       0x97D2D988u, 0x09B64C2Bu, 0x7EB17CBDu, 0xE7B82D07u, 0x90BF1D91u, 0x1DB71064u, 0x6AB020F2u, 0xF3B97148u, 0x84BE41DEu, 0x1ADAD47Du, 0x6DDDE4EBu, 0xF4D4B551u, 0x83D385C7u, 0x136C9856u, 0x646BA8C0u, 
@@ -105,10 +150,10 @@ namespace IttyZip
       0xA9BCAE53u, 0xDEBB9EC5u, 0x47B2CF7Fu, 0x30B5FFE9u, 0xBDBDF21Cu, 0xCABAC28Au, 0x53B39330u, 0x24B4A3A6u, 0xBAD03605u, 0xCDD70693u, 0x54DE5729u, 0x23D967BFu, 0xB3667A2Eu, 0xC4614AB8u, 0x5D681B02u, 
       0x2A6F2B94u, 0xB40BBE37u, 0xC30C8EA1u, 0x5A05DF1Bu, 0x2D02EF8Du};
 
-    uint32_t crc_reg = 0xFFFFFFFFu;
-    for (size_t jChar = 0u; jChar < data.size(); jChar++)
+    uint32_t crc_reg = crc ^ 0xFFFFFFFFu;
+    for (size_t jChar = 0u; jChar < length; jChar++)
     {
-      uint8_t table_indx = static_cast<uint8_t>(0x000000FFu & crc_reg) ^ static_cast<uint8_t>(data.at(jChar));
+      uint8_t table_indx = static_cast<uint8_t>(0x000000FFu & crc_reg) ^ static_cast<uint8_t>(data[jChar]);
       crc_reg >>= 8;
       crc_reg ^= crc32_table[table_indx];
     }
@@ -140,18 +185,51 @@ namespace IttyZip
     out[3] = static_cast<char>(0x000000FFu & (in >> 24));
   }
 
+  /**
+   * Helper routine that reads a uint16_t value stored
+   * in little endian byte order from an input buffer
+   * >= 2 bytes long.
+   */
+  uint16_t buffer_to_uint16(const char *in) noexcept
+  {
+    return static_cast<uint16_t>(static_cast<uint8_t>(in[0]) |
+                                 (static_cast<uint16_t>(static_cast<uint8_t>(in[1])) << 8));
+  }
+
+  /**
+   * Helper routine that reads a uint32_t value stored
+   * in little endian byte order from an input buffer
+   * >= 4 bytes long.
+   */
+  uint32_t buffer_to_uint32(const char *in) noexcept
+  {
+    return static_cast<uint32_t>(static_cast<uint8_t>(in[0])) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(in[1])) << 8) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(in[2])) << 16) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(in[3])) << 24);
+  }
+
+  /**
+   * Closes a C stdio file owned by a std::unique_ptr.
+   */
+  void file_closer::operator() (std::FILE *file) const noexcept
+  {
+    std::fclose(file);
+  }
+
   /**
    * Default constructor.
    * Use the IttyZip::open() method to specify the output file
    * if the IttyZip object is constructed with this constructor.
    */
-  IttyZip::IttyZip(void) noexcept : num_files(0u), opened(false), next_offset(0u) { }
+  IttyZip::IttyZip(void) noexcept : num_files(0u), opened(false), next_offset(0u), spill_duplicate_check(false), entry_open(false), spill_threshold(0u), spilled_size(0u), stats(), entry_stats()
+  { }
 
   /**
    * Constructor that takes an output file filename
    * and attempts to open said output file.
    */
-  IttyZip::IttyZip(const std::string &outputFilename) noexcept(false) : num_files(0u), next_offset(0u)
+  IttyZip::IttyZip(const std::string &outputFilename) noexcept(false) : num_files(0u), next_offset(0u), spill_duplicate_check(false), entry_open(false), spill_threshold(0u), spilled_size(0u), stats(), entry_stats()
   {
     opened = false;
     out_file.open(outputFilename, std::ios::binary | std::ios::out | std::ios::trunc);
@@ -183,7 +261,13 @@ namespace IttyZip
       opened = false;
       num_files = 0u;
       next_offset = 0u;
-      central_directory.clear();
+      entry_open = false;
+      clearDirectory();
+      spill_file.reset();
+      spilled_size = 0u;
+#ifdef ITTYZIP_STATS
+      stats = zipstats_t();
+#endif
       out_file.open(outputFilename, std::ios::binary | std::ios::out | std::ios::trunc);
       if (!out_file.is_open())
       {
@@ -206,11 +290,24 @@ namespace IttyZip
    * object that has an open output file.
    */
   void IttyZip::addFile(const std::string &filename, const std::string &contents) noexcept(false)
+  {
+    addFile(filename, contents.c_str(), contents.size());
+  }
+
+  /**
+   * Alternative option for addFile() that takes the contents as
+   * length characters starting at contents.
+   */
+  void IttyZip::addFile(const std::string &filename, const char *contents, const size_t length) noexcept(false)
   {
     if (!opened)
     {
       throw std::runtime_error(std::string(NOT_OPENED_MESG));
     }
+    else if (entry_open)
+    {
+      throw std::runtime_error(std::string(ENTRY_OPEN_MESG));
+    }
     else if (!out_file.is_open())
     {
       throw std::runtime_error(std::string(UNEXPECTED_CLOSE_MESG));
@@ -221,21 +318,241 @@ namespace IttyZip
     }
     else
     {
-      uint32_t file_crc32 = crc32(contents);
-      std::pair<localheader_t, dirheader_t> file_headers = generateHeaders(filename, static_cast<uint32_t>(contents.size()), file_crc32);
-      std::pair<std::set<std::string>::iterator, bool> ins_ret = filenames.insert(file_headers.first.filename);
-      if (!ins_ret.second)
+#ifdef ITTYZIP_STATS
+      entrystats_t file_stats = entrystats_t();
+      std::chrono::steady_clock::time_point crc_start = std::chrono::steady_clock::now();
+#endif
+      uint32_t file_crc32 = crc32(0u, contents, length);
+#ifdef ITTYZIP_STATS
+      file_stats.checksum_ns = nanoseconds_since(crc_start);
+      std::chrono::steady_clock::time_point header_start = std::chrono::steady_clock::now();
+#endif
+      std::pair<localheader_t, dirheader_t> file_headers = generateHeaders(filename, static_cast<uint32_t>(length), file_crc32);
+      if (static_cast<uint64_t>(next_offset) + 30u + file_headers.first.filename_length + length > 0xFFFFFFFFu)
+      {
+        throw std::runtime_error(std::string(TOO_LARGE_MESG));
+      }
+      else if (!rememberFilename(file_headers.first.filename))
       {
         throw std::runtime_error(std::string(DUPLICATE_FILE_MESG));
       }
       else
       {
         storeDirheader(file_headers.second);
+        if (spill_threshold > 0u && directorySize() >= spill_threshold)
+        {
+          spillDirectory();
+        }
+#ifdef ITTYZIP_STATS
+        file_stats.header_ns = nanoseconds_since(header_start);
+        uint64_t write_ns_before = stats.write_ns;
+        uint64_t write_calls_before = stats.write_calls;
+        uint64_t bytes_out_before = stats.bytes_out;
+#endif
         next_offset += writeLocalheader(file_headers.first);
-        out_file.write(contents.c_str(), contents.length());
-        next_offset += static_cast<uint32_t>(contents.size());
+        writeBytes(contents, length);
+        next_offset += static_cast<uint32_t>(length);
         num_files++;
+#ifdef ITTYZIP_STATS
+        file_stats.filename = file_headers.first.filename;
+        file_stats.bytes_in = length;
+        file_stats.bytes_out = stats.bytes_out - bytes_out_before;
+        file_stats.write_ns = stats.write_ns - write_ns_before;
+        file_stats.write_calls = stats.write_calls - write_calls_before;
+        stats.bytes_in += file_stats.bytes_in;
+        stats.checksum_ns += file_stats.checksum_ns;
+        stats.header_ns += file_stats.header_ns;
+        if (spill_threshold == 0u)
+        {
+          stats.entries.push_back(std::move(file_stats));
+        }
+#endif
+      }
+    }
+  }
+
+  /**
+   * beginFile() starts a new file in the IttyZip archive whose
+   * contents are not all known up front. filename specifies the
+   * full path of the file in the archive. The contents are then
+   * passed, in any number of pieces, to writeFileData(), and
+   * endFile() completes the file.
+   *
+   * The local file header is written immediately with a zero
+   * CRC-32 and size, and endFile() seeks back to fill them in,
+   * so the archive is the same as if the whole contents had
+   * been passed to addFile(). Only one file may be open at a
+   * time; addFile() and finalize() throw while it is.
+   */
+  void IttyZip::beginFile(const std::string &filename) noexcept(false)
+  {
+    if (!opened)
+    {
+      throw std::runtime_error(std::string(NOT_OPENED_MESG));
+    }
+    else if (entry_open)
+    {
+      throw std::runtime_error(std::string(ENTRY_OPEN_MESG));
+    }
+    else if (!out_file.is_open())
+    {
+      throw std::runtime_error(std::string(UNEXPECTED_CLOSE_MESG));
+    }
+    else if (out_file.fail())
+    {
+      throw std::runtime_error(std::string(OUTPUT_FAIL_MESG));
+    }
+    else
+    {
+#ifdef ITTYZIP_STATS
+      entry_stats = entrystats_t();
+      std::chrono::steady_clock::time_point header_start = std::chrono::steady_clock::now();
+#endif
+      entry_headers = generateHeaders(filename, 0u, 0u);
+      if (static_cast<uint64_t>(next_offset) + 30u + entry_headers.first.filename_length > 0xFFFFFFFFu)
+      {
+        throw std::runtime_error(std::string(TOO_LARGE_MESG));
+      }
+      else if (!rememberFilename(entry_headers.first.filename))
+      {
+        throw std::runtime_error(std::string(DUPLICATE_FILE_MESG));
+      }
+      else
+      {
+#ifdef ITTYZIP_STATS
+        entry_stats.header_ns = nanoseconds_since(header_start);
+        uint64_t write_ns_before = stats.write_ns;
+        uint64_t write_calls_before = stats.write_calls;
+        uint64_t bytes_out_before = stats.bytes_out;
+#endif
+        next_offset += writeLocalheader(entry_headers.first);
+        entry_open = true;
+#ifdef ITTYZIP_STATS
+        entry_stats.filename = entry_headers.first.filename;
+        entry_stats.bytes_out = stats.bytes_out - bytes_out_before;
+        entry_stats.write_ns = stats.write_ns - write_ns_before;
+        entry_stats.write_calls = stats.write_calls - write_calls_before;
+#endif
+      }
+    }
+  }
+
+  /**
+   * writeFileData() appends length bytes at data to the file
+   * opened by beginFile(), writing them to the output archive
+   * immediately.
+   */
+  void IttyZip::writeFileData(const char *data, const size_t length) noexcept(false)
+  {
+    if (!entry_open)
+    {
+      throw std::runtime_error(std::string(NO_ENTRY_MESG));
+    }
+    else if (!out_file.is_open())
+    {
+      throw std::runtime_error(std::string(UNEXPECTED_CLOSE_MESG));
+    }
+    else if (out_file.fail())
+    {
+      throw std::runtime_error(std::string(OUTPUT_FAIL_MESG));
+    }
+    else if (static_cast<uint64_t>(next_offset) + length > 0xFFFFFFFFu)
+    {
+      throw std::runtime_error(std::string(TOO_LARGE_MESG));
+    }
+    else
+    {
+#ifdef ITTYZIP_STATS
+      std::chrono::steady_clock::time_point crc_start = std::chrono::steady_clock::now();
+#endif
+      entry_headers.second.crc32 = crc32(entry_headers.second.crc32, data, length);
+#ifdef ITTYZIP_STATS
+      entry_stats.checksum_ns += nanoseconds_since(crc_start);
+      uint64_t write_ns_before = stats.write_ns;
+#endif
+      writeBytes(data, length);
+      entry_headers.second.size_uncompressed += static_cast<uint32_t>(length);
+      next_offset += static_cast<uint32_t>(length);
+#ifdef ITTYZIP_STATS
+      entry_stats.bytes_in += length;
+      entry_stats.bytes_out += length;
+      entry_stats.write_ns += stats.write_ns - write_ns_before;
+      entry_stats.write_calls++;
+#endif
+    }
+  }
+
+  /**
+   * Convenience overload of writeFileData() for string data.
+   */
+  void IttyZip::writeFileData(const std::string &data) noexcept(false)
+  {
+    writeFileData(data.c_str(), data.size());
+  }
+
+  /**
+   * endFile() completes the file opened by beginFile(): it fills
+   * the CRC-32 and size into the file's local header and records
+   * the file for the central directory.
+   */
+  void IttyZip::endFile(void) noexcept(false)
+  {
+    if (!entry_open)
+    {
+      throw std::runtime_error(std::string(NO_ENTRY_MESG));
+    }
+    else if (!out_file.is_open())
+    {
+      throw std::runtime_error(std::string(UNEXPECTED_CLOSE_MESG));
+    }
+    else if (out_file.fail())
+    {
+      throw std::runtime_error(std::string(OUTPUT_FAIL_MESG));
+    }
+    else
+    {
+      dirheader_t &dirheader = entry_headers.second;
+      dirheader.size_compressed = dirheader.size_uncompressed;
+
+      /* CRC-32, compressed size and uncompressed size sit 14 bytes into the local header. */
+      char write_buffer[12];
+      uint32_to_buffer(dirheader.crc32, write_buffer);
+      uint32_to_buffer(dirheader.size_compressed, write_buffer + 4);
+      uint32_to_buffer(dirheader.size_uncompressed, write_buffer + 8);
+#ifdef ITTYZIP_STATS
+      uint64_t write_ns_before = stats.write_ns;
+#endif
+      out_file.seekp(static_cast<std::streamoff>(dirheader.local_header_offset) + 14);
+      if (out_file.fail())
+      {
+        throw std::runtime_error(std::string(SEEK_FAIL_MESG));
+      }
+      writeBytes(write_buffer, 12u);
+      out_file.seekp(static_cast<std::streamoff>(next_offset));
+      if (out_file.fail())
+      {
+        throw std::runtime_error(std::string(SEEK_FAIL_MESG));
       }
+
+      entry_open = false;
+      storeDirheader(dirheader);
+      if (spill_threshold > 0u && directorySize() >= spill_threshold)
+      {
+        spillDirectory();
+      }
+      num_files++;
+#ifdef ITTYZIP_STATS
+      entry_stats.bytes_out += 12u;
+      entry_stats.write_ns += stats.write_ns - write_ns_before;
+      entry_stats.write_calls++;
+      stats.bytes_in += entry_stats.bytes_in;
+      stats.checksum_ns += entry_stats.checksum_ns;
+      stats.header_ns += entry_stats.header_ns;
+      if (spill_threshold == 0u)
+      {
+        stats.entries.push_back(std::move(entry_stats));
+      }
+#endif
     }
   }
 
@@ -250,7 +567,7 @@ namespace IttyZip
    */
   void IttyZip::finalize(void) noexcept(false)
   {
-    if (num_files == 0u || next_offset == 0u || central_directory.empty())
+    if (num_files == 0u || next_offset == 0u)
     {
       throw std::runtime_error(std::string(EMPTY_FINALIZE_MESG));
     }
@@ -258,6 +575,10 @@ namespace IttyZip
     {
       throw std::runtime_error(std::string(NOT_OPENED_MESG));
     }
+    else if (entry_open)
+    {
+      throw std::runtime_error(std::string(ENTRY_OPEN_MESG));
+    }
     else if (!out_file.is_open())
     {
       throw std::runtime_error(std::string(UNEXPECTED_CLOSE_MESG));
@@ -268,18 +589,115 @@ namespace IttyZip
     }
     else
     {
-      out_file.write(central_directory.c_str(), central_directory.size());
+      if (spill_file)
+      {
+        if (std::fflush(spill_file.get()) != 0 || std::fseek(spill_file.get(), 0L, SEEK_SET) != 0)
+        {
+          throw std::runtime_error(std::string(SPILL_FAIL_MESG));
+        }
+
+        /* Stream the spilled directory back through a bounded buffer. */
+        std::vector<char> copy_buffer(65536u);
+        uint64_t remaining = spilled_size;
+        while (remaining > 0u)
+        {
+          size_t this_block = static_cast<size_t>(std::min<uint64_t>(remaining, copy_buffer.size()));
+          if (std::fread(copy_buffer.data(), 1u, this_block, spill_file.get()) != this_block)
+          {
+            throw std::runtime_error(std::string(SPILL_FAIL_MESG));
+          }
+          writeBytes(copy_buffer.data(), this_block);
+          remaining -= this_block;
+        }
+      }
+
+      uint64_t central_dir_size = spilled_size + directorySize();
+      emitDirectory(false);
+      if (num_files > 0xFFFFu)
+      {
+        writeZip64EndRecord(central_dir_size, next_offset);
+      }
       endrecord_t end_record = generateEndRecord();
       writeEndRecord(end_record);
       out_file.close();
       opened = false;
       next_offset = 0u;
-      central_directory.clear();
+      clearDirectory();
+      spill_file.reset();
+      spilled_size = 0u;
       num_files = 0u;
       filenames.clear();
+      filename_hashes.clear();
     }
   }
 
+  /**
+   * discard() abandons the archive being written: the output
+   * file is closed as it stands, without a central directory,
+   * and the IttyZip object is ready for open() again. The
+   * in-memory central directory keeps its capacity. Does nothing
+   * to a closed IttyZip object.
+   */
+  void IttyZip::discard(void) noexcept
+  {
+    if (out_file.is_open())
+    {
+      out_file.close();
+    }
+    out_file.clear();
+    opened = false;
+    num_files = 0u;
+    next_offset = 0u;
+    entry_open = false;
+    clearDirectory();
+    spill_file.reset();
+    spilled_size = 0u;
+    filenames.clear();
+    filename_hashes.clear();
+  }
+
+  /**
+   * setSpillThreshold() bounds the memory used by the central
+   * directory of archives with very many files. Once the central
+   * directory held in memory reaches threshold bytes, it is moved
+   * out to an anonymous temporary file, and finalize() streams it
+   * back into the archive. A threshold of 0 (the default) keeps
+   * the whole central directory in memory.
+   *
+   * With a nonzero threshold, filenames are not kept, so duplicate
+   * filenames are not detected unless check_duplicates is true.
+   * addFile() then remembers a 64 bit hash of each filename, which
+   * costs about 40 bytes of memory per file, and two different
+   * filenames with the same hash would be reported as duplicates,
+   * which is vanishingly unlikely. With ITTYZIP_STATS defined, only
+   * the archive totals are counted.
+   *
+   * The threshold must be set before the first file of an archive
+   * is added; it then applies to every later archive as well.
+   */
+  void IttyZip::setSpillThreshold(const size_t threshold, const bool check_duplicates) noexcept(false)
+  {
+    if (num_files > 0u || entry_open)
+    {
+      throw std::runtime_error(std::string(LATE_SPILL_MESG));
+    }
+    spill_threshold = threshold;
+    spill_duplicate_check = check_duplicates;
+  }
+
+  /**
+   * getStats() returns the counters collected for the archive
+   * currently being written or, after finalize(), for the last
+   * archive written. The counters are cleared by open().
+   *
+   * If IttyZip was compiled without ITTYZIP_STATS defined, no
+   * counters are collected and the returned zipstats_t is empty.
+   */
+  const zipstats_t& IttyZip::getStats(void) const noexcept
+  {
+    return stats;
+  }
+
   /**
    * Generates the local file header and the central directory
    * file header for the file with name filename, size file_size
@@ -299,14 +717,14 @@ namespace IttyZip
      * is the default and appropriate, as we are not using
      * special features.
      */
-    output.first.extract_version = 0x000Au;
+    output.first.extract_version = ZIP_VERSION;
     output.second.version_made_by = output.first.extract_version;
     output.second.extract_version = output.first.extract_version;
     /* Not using anything special in the general bit flag field. */
-    output.first.general_bit_flag = 0u;
+    output.first.general_bit_flag = ZIP_BIT_FLAG;
     output.second.general_bit_flag = output.first.general_bit_flag;
     /* "Compression" method is store: no compression. */
-    output.first.compression_method = 0u;
+    output.first.compression_method = ZIP_METHOD_STORE;
     output.second.compression_method = output.first.compression_method;
     /* Simply use the current time and date for file modification. */
     output.first.file_mod_timedate = dosTimeDate();
@@ -356,30 +774,20 @@ namespace IttyZip
     }
     else
     {
-      char write_buffer[4];
+      char write_buffer[30];
       uint32_to_buffer(localheader.signature, write_buffer);
-      out_file.write(write_buffer, 4);
-      uint16_to_buffer(localheader.extract_version, write_buffer);
-      out_file.write(write_buffer, 2);
-      uint16_to_buffer(localheader.general_bit_flag, write_buffer);
-      out_file.write(write_buffer, 2);
-      uint16_to_buffer(localheader.compression_method, write_buffer);
-      out_file.write(write_buffer, 2);
-      uint16_to_buffer(localheader.file_mod_timedate.time, write_buffer);
-      out_file.write(write_buffer, 2);
-      uint16_to_buffer(localheader.file_mod_timedate.date, write_buffer);
-      out_file.write(write_buffer, 2);
-      uint32_to_buffer(localheader.crc32, write_buffer);
-      out_file.write(write_buffer, 4);
-      uint32_to_buffer(localheader.size_compressed, write_buffer);
-      out_file.write(write_buffer, 4);
-      uint32_to_buffer(localheader.size_uncompressed, write_buffer);
-      out_file.write(write_buffer, 4);
-      uint16_to_buffer(localheader.filename_length, write_buffer);
-      out_file.write(write_buffer, 2);
-      uint16_to_buffer(localheader.extra_field_length, write_buffer);
-      out_file.write(write_buffer, 2);
-      out_file.write(localheader.filename.c_str(), localheader.filename_length);
+      uint16_to_buffer(localheader.extract_version, write_buffer + 4);
+      uint16_to_buffer(localheader.general_bit_flag, write_buffer + 6);
+      uint16_to_buffer(localheader.compression_method, write_buffer + 8);
+      uint16_to_buffer(localheader.file_mod_timedate.time, write_buffer + 10);
+      uint16_to_buffer(localheader.file_mod_timedate.date, write_buffer + 12);
+      uint32_to_buffer(localheader.crc32, write_buffer + 14);
+      uint32_to_buffer(localheader.size_compressed, write_buffer + 18);
+      uint32_to_buffer(localheader.size_uncompressed, write_buffer + 22);
+      uint16_to_buffer(localheader.filename_length, write_buffer + 26);
+      uint16_to_buffer(localheader.extra_field_length, write_buffer + 28);
+      writeBytes(write_buffer, 30u);
+      writeBytes(localheader.filename.c_str(), localheader.filename_length);
       return 30u + static_cast<uint32_t>(localheader.filename_length);
     }
 
@@ -387,47 +795,213 @@ namespace IttyZip
   }
 
   /**
-   * Appends the central directory file header dirheader
-   * to the data member central_directory.
+   * Writes the ZIP64 end of central directory record and its
+   * locator, which carry the file count of archives with more
+   * than 65535 files. Purely a subroutine of finalize().
+   */
+  void IttyZip::writeZip64EndRecord(const uint64_t central_dir_size, const uint64_t central_dir_offset) noexcept(false)
+  {
+    if (!opened)
+    {
+      throw std::runtime_error(std::string(NOT_OPENED_MESG));
+    }
+    else if (!out_file.is_open())
+    {
+      throw std::runtime_error(std::string(UNEXPECTED_CLOSE_MESG));
+    }
+    else if (out_file.fail())
+    {
+      throw std::runtime_error(std::string(OUTPUT_FAIL_MESG));
+    }
+    else
+    {
+      uint64_t record_offset = central_dir_offset + central_dir_size;
+      char write_buffer[76];
+      /* ZIP64 end of central directory record */
+      uint32_to_buffer(0x06064b50u, write_buffer);
+      /* Size of the rest of the record, then version 4.5 made by / needed. */
+      uint32_to_buffer(44u, write_buffer + 4);
+      uint32_to_buffer(0u, write_buffer + 8);
+      uint16_to_buffer(0x002Du, write_buffer + 12);
+      uint16_to_buffer(0x002Du, write_buffer + 14);
+      /* Everything is on disk 0. */
+      uint32_to_buffer(0u, write_buffer + 16);
+      uint32_to_buffer(0u, write_buffer + 20);
+      uint32_to_buffer(num_files, write_buffer + 24);
+      uint32_to_buffer(0u, write_buffer + 28);
+      uint32_to_buffer(num_files, write_buffer + 32);
+      uint32_to_buffer(0u, write_buffer + 36);
+      uint32_to_buffer(static_cast<uint32_t>(central_dir_size), write_buffer + 40);
+      uint32_to_buffer(static_cast<uint32_t>(central_dir_size >> 32), write_buffer + 44);
+      uint32_to_buffer(static_cast<uint32_t>(central_dir_offset), write_buffer + 48);
+      uint32_to_buffer(static_cast<uint32_t>(central_dir_offset >> 32), write_buffer + 52);
+      /* ZIP64 end of central directory locator */
+      uint32_to_buffer(0x07064b50u, write_buffer + 56);
+      uint32_to_buffer(0u, write_buffer + 60);
+      uint32_to_buffer(static_cast<uint32_t>(record_offset), write_buffer + 64);
+      uint32_to_buffer(static_cast<uint32_t>(record_offset >> 32), write_buffer + 68);
+      uint32_to_buffer(1u, write_buffer + 72);
+      writeBytes(write_buffer, 76u);
+    }
+  }
+
+  /**
+   * All output to the archive file passes through writeBytes()
+   * so that writes can be counted and timed when ITTYZIP_STATS
+   * is defined. Stream errors are detected by the callers through
+   * out_file.fail().
+   */
+  void IttyZip::writeBytes(const char *data, const size_t length) noexcept
+  {
+#ifdef ITTYZIP_STATS
+    std::chrono::steady_clock::time_point write_start = std::chrono::steady_clock::now();
+#endif
+    out_file.write(data, length);
+#ifdef ITTYZIP_STATS
+    stats.write_ns += nanoseconds_since(write_start);
+    stats.write_calls++;
+    stats.bytes_out += length;
+#endif
+  }
+
+  /**
+   * Records filename as added to the archive. Returns false,
+   * recording nothing, if a file of the same name (or, when
+   * spilling, of the same filename hash) was already added.
+   * Always returns true when spilling without duplicate checks.
+   */
+  bool IttyZip::rememberFilename(const std::string &filename) noexcept(false)
+  {
+    if (spill_threshold == 0u)
+    {
+      return filenames.insert(filename).second;
+    }
+    else if (spill_duplicate_check)
+    {
+      return filename_hashes.insert(filename_hash(filename)).second;
+    }
+    return true;
+  }
+
+  /**
+   * Stores the fields of the central directory file header
+   * dirheader that vary from file to file. The filename goes
+   * into the dir_names arena; all other fields are constant
+   * and are filled back in by appendDirheader().
    */
   void IttyZip::storeDirheader(const dirheader_t &dirheader) noexcept
   {
-    char store_buffer[4];
-    uint32_to_buffer(dirheader.signature, store_buffer);
-    central_directory.append(store_buffer, 4);
-    uint16_to_buffer(dirheader.version_made_by, store_buffer);
-    central_directory.append(store_buffer, 2);
-    uint16_to_buffer(dirheader.extract_version, store_buffer);
-    central_directory.append(store_buffer, 2);
-    uint16_to_buffer(dirheader.general_bit_flag, store_buffer);
-    central_directory.append(store_buffer, 2);
-    uint16_to_buffer(dirheader.compression_method, store_buffer);
-    central_directory.append(store_buffer, 2);
-    uint16_to_buffer(dirheader.file_mod_timedate.time, store_buffer);
-    central_directory.append(store_buffer, 2);
-    uint16_to_buffer(dirheader.file_mod_timedate.date, store_buffer);
-    central_directory.append(store_buffer, 2);
-    uint32_to_buffer(dirheader.crc32, store_buffer);
-    central_directory.append(store_buffer, 4);
-    uint32_to_buffer(dirheader.size_compressed, store_buffer);
-    central_directory.append(store_buffer, 4);
-    uint32_to_buffer(dirheader.size_uncompressed, store_buffer);
-    central_directory.append(store_buffer, 4);
-    uint16_to_buffer(dirheader.filename_length, store_buffer);
-    central_directory.append(store_buffer, 2);
-    uint16_to_buffer(dirheader.extra_field_length, store_buffer);
-    central_directory.append(store_buffer, 2);
-    uint16_to_buffer(dirheader.comment_length, store_buffer);
-    central_directory.append(store_buffer, 2);
-    uint16_to_buffer(dirheader.disk_number_start, store_buffer);
-    central_directory.append(store_buffer, 2);
-    uint16_to_buffer(dirheader.internal_attributes, store_buffer);
-    central_directory.append(store_buffer, 2);
-    uint32_to_buffer(dirheader.external_attributes, store_buffer);
-    central_directory.append(store_buffer, 4);
-    uint32_to_buffer(dirheader.local_header_offset, store_buffer);
-    central_directory.append(store_buffer, 4);
-    central_directory.append(dirheader.filename, 0u, dirheader.filename_length);
+    dir_crc32s.push_back(dirheader.crc32);
+    dir_sizes.push_back(dirheader.size_uncompressed);
+    dir_offsets.push_back(dirheader.local_header_offset);
+    dir_timedates.push_back(static_cast<uint32_t>(dirheader.file_mod_timedate.time) |
+                            (static_cast<uint32_t>(dirheader.file_mod_timedate.date) << 16));
+    dir_name_offsets.push_back(static_cast<uint32_t>(dir_names.size()));
+    dir_names.append(dirheader.filename, 0u, dirheader.filename_length);
+  }
+
+  /**
+   * Serializes the central directory file header of the file
+   * stored at index in the dir_* arrays and appends it to buffer.
+   */
+  void IttyZip::appendDirheader(const size_t index, std::string &buffer) const noexcept
+  {
+    size_t name_start = dir_name_offsets[index];
+    size_t name_end = (index + 1u < dir_name_offsets.size() ? dir_name_offsets[index + 1u] : dir_names.size());
+    uint32_t timedate = dir_timedates[index];
+
+    char record[46];
+    uint32_to_buffer(0x02014b50u, record);
+    uint16_to_buffer(ZIP_VERSION, record + 4);
+    uint16_to_buffer(ZIP_VERSION, record + 6);
+    uint16_to_buffer(ZIP_BIT_FLAG, record + 8);
+    uint16_to_buffer(ZIP_METHOD_STORE, record + 10);
+    uint16_to_buffer(static_cast<uint16_t>(timedate), record + 12);
+    uint16_to_buffer(static_cast<uint16_t>(timedate >> 16), record + 14);
+    uint32_to_buffer(dir_crc32s[index], record + 16);
+    uint32_to_buffer(dir_sizes[index], record + 20);
+    uint32_to_buffer(dir_sizes[index], record + 24);
+    uint16_to_buffer(static_cast<uint16_t>(name_end - name_start), record + 28);
+    /* No extra field, comment, disk number, or attributes. */
+    std::fill(record + 30, record + 42, '\0');
+    uint32_to_buffer(dir_offsets[index], record + 42);
+    buffer.append(record, 46u);
+    buffer.append(dir_names, name_start, name_end - name_start);
+  }
+
+  /**
+   * Size in bytes of the part of the central directory that
+   * is still held in memory, once serialized.
+   */
+  size_t IttyZip::directorySize(void) const noexcept
+  {
+    return 46u * dir_crc32s.size() + dir_names.size();
+  }
+
+  /**
+   * Empties the in-memory central directory while keeping the
+   * capacity of its arrays for the files that follow.
+   */
+  void IttyZip::clearDirectory(void) noexcept
+  {
+    dir_crc32s.clear();
+    dir_sizes.clear();
+    dir_offsets.clear();
+    dir_timedates.clear();
+    dir_name_offsets.clear();
+    dir_names.clear();
+  }
+
+  /**
+   * Serializes the in-memory central directory in blocks of
+   * about 64 KiB, writing them either to the output file or,
+   * if to_spill_file is true, to spill_file. The in-memory
+   * directory is left unchanged.
+   */
+  void IttyZip::emitDirectory(const bool to_spill_file) noexcept(false)
+  {
+    const size_t BLOCK_SIZE = 65536u;
+    std::string &block = dir_block;
+    block.clear();
+    block.reserve(BLOCK_SIZE + 46u + 65535u);
+
+    for (size_t jFile = 0u; jFile < dir_crc32s.size(); jFile++)
+    {
+      appendDirheader(jFile, block);
+      if (block.size() >= BLOCK_SIZE || jFile + 1u == dir_crc32s.size())
+      {
+        if (!to_spill_file)
+        {
+          writeBytes(block.c_str(), block.size());
+        }
+        else if (std::fwrite(block.c_str(), 1u, block.size(), spill_file.get()) != block.size())
+        {
+          throw std::runtime_error(std::string(SPILL_FAIL_MESG));
+        }
+        block.clear();
+      }
+    }
+  }
+
+  /**
+   * Appends the in-memory central directory to spill_file,
+   * creating the file on first use, and then empties the
+   * in-memory directory.
+   */
+  void IttyZip::spillDirectory(void) noexcept(false)
+  {
+    if (!spill_file)
+    {
+      spill_file.reset(std::tmpfile());
+      if (!spill_file)
+      {
+        throw std::runtime_error(std::string(SPILL_FAIL_MESG));
+      }
+    }
+
+    spilled_size += directorySize();
+    emitDirectory(true);
+    clearDirectory();
   }
 
   /**
@@ -442,9 +1016,10 @@ namespace IttyZip
     /* Everything is on disk 0 in this archive. */
     output.disk_number = 0u;
     output.dir_start_disk_number = 0u;
-    output.this_disk_entries = num_files;
+    /* 0xFFFF defers to the ZIP64 end of central directory record. */
+    output.this_disk_entries = static_cast<uint16_t>(std::min<uint32_t>(num_files, 0xFFFFu));
     output.total_entries = output.this_disk_entries;
-    output.central_dir_size = static_cast<uint32_t>(central_directory.size());
+    output.central_dir_size = static_cast<uint32_t>(spilled_size + directorySize());
     output.central_dir_offset = next_offset;
     /* No file comment. */
     output.comment_length = 0u;
@@ -471,23 +1046,278 @@ namespace IttyZip
     }
     else
     {
-      char write_buffer[4];
+      char write_buffer[22];
       uint32_to_buffer(end_record.signature, write_buffer);
-      out_file.write(write_buffer, 4);
-      uint16_to_buffer(end_record.disk_number, write_buffer);
-      out_file.write(write_buffer, 2);
-      uint16_to_buffer(end_record.dir_start_disk_number, write_buffer);
-      out_file.write(write_buffer, 2);
-      uint16_to_buffer(end_record.this_disk_entries, write_buffer);
-      out_file.write(write_buffer, 2);
-      uint16_to_buffer(end_record.total_entries, write_buffer);
-      out_file.write(write_buffer, 2);
-      uint32_to_buffer(end_record.central_dir_size, write_buffer);
-      out_file.write(write_buffer, 4);
-      uint32_to_buffer(end_record.central_dir_offset, write_buffer);
-      out_file.write(write_buffer, 4);
-      uint16_to_buffer(end_record.comment_length, write_buffer);
-      out_file.write(write_buffer, 2);
+      uint16_to_buffer(end_record.disk_number, write_buffer + 4);
+      uint16_to_buffer(end_record.dir_start_disk_number, write_buffer + 6);
+      uint16_to_buffer(end_record.this_disk_entries, write_buffer + 8);
+      uint16_to_buffer(end_record.total_entries, write_buffer + 10);
+      uint32_to_buffer(end_record.central_dir_size, write_buffer + 12);
+      uint32_to_buffer(end_record.central_dir_offset, write_buffer + 16);
+      uint16_to_buffer(end_record.comment_length, write_buffer + 20);
+      writeBytes(write_buffer, 22u);
+    }
+  }
+
+  /**
+   * Reader constructor. Opens the archive inputFilename, locates
+   * the end of central directory record, and parses every central
+   * directory file header into entries.
+   */
+  Reader::Reader(const std::string &inputFilename) noexcept(false) : input_filename(inputFilename), file_size(0u)
+  {
+    std::ifstream input = openInput();
+    input.seekg(0, std::ios::end);
+    if (input.fail())
+    {
+      throw std::runtime_error(std::string(INPUT_FAIL_MESG));
+    }
+    file_size = static_cast<uint64_t>(input.tellg());
+
+    /**
+     * The end of central directory record is 22 bytes followed
+     * by a comment of up to 65535 bytes, so search backwards
+     * through at most the last 65557 bytes for its signature.
+     */
+    const uint64_t END_RECORD_SIZE = 22u;
+    if (file_size < END_RECORD_SIZE)
+    {
+      throw std::runtime_error(std::string(NO_END_RECORD_MESG));
+    }
+    uint64_t tail_size = std::min<uint64_t>(file_size, END_RECORD_SIZE + 65535u);
+    std::string tail(static_cast<size_t>(tail_size), '\0');
+    input.seekg(static_cast<std::streamoff>(file_size - tail_size));
+    input.read(&tail[0], static_cast<std::streamsize>(tail_size));
+    if (input.fail())
+    {
+      throw std::runtime_error(std::string(INPUT_FAIL_MESG));
+    }
+
+    size_t end_pos = std::string::npos;
+    for (size_t jPos = tail.size() - END_RECORD_SIZE + 1u; jPos > 0u; jPos--)
+    {
+      if (buffer_to_uint32(&tail[jPos - 1u]) == 0x06054b50u)
+      {
+        end_pos = jPos - 1u;
+        break;
+      }
+    }
+    if (end_pos == std::string::npos)
+    {
+      throw std::runtime_error(std::string(NO_END_RECORD_MESG));
+    }
+
+    uint64_t total_entries = buffer_to_uint16(&tail[end_pos + 10u]);
+    uint64_t central_dir_size = buffer_to_uint32(&tail[end_pos + 12u]);
+    uint64_t central_dir_offset = buffer_to_uint32(&tail[end_pos + 16u]);
+
+    /**
+     * A file count of 0xFFFF may mean the real count is in a
+     * ZIP64 end of central directory record, whose 20 byte
+     * locator immediately precedes the end record.
+     */
+    if (total_entries == 0xFFFFu && end_pos >= 20u &&
+        buffer_to_uint32(&tail[end_pos - 20u]) == 0x07064b50u)
+    {
+      uint64_t record_offset = buffer_to_uint32(&tail[end_pos - 12u]) |
+                               (static_cast<uint64_t>(buffer_to_uint32(&tail[end_pos - 8u])) << 32);
+      char record[56];
+      if (record_offset + 56u > file_size)
+      {
+        throw std::runtime_error(std::string(BAD_DIRECTORY_MESG));
+      }
+      input.seekg(static_cast<std::streamoff>(record_offset));
+      input.read(record, 56);
+      if (input.fail() || buffer_to_uint32(record) != 0x06064b50u)
+      {
+        throw std::runtime_error(std::string(BAD_DIRECTORY_MESG));
+      }
+      total_entries = buffer_to_uint32(record + 32) | (static_cast<uint64_t>(buffer_to_uint32(record + 36)) << 32);
+      central_dir_size = buffer_to_uint32(record + 40) | (static_cast<uint64_t>(buffer_to_uint32(record + 44)) << 32);
+      central_dir_offset = buffer_to_uint32(record + 48) | (static_cast<uint64_t>(buffer_to_uint32(record + 52)) << 32);
+    }
+
+    if (central_dir_offset + central_dir_size > file_size ||
+        total_entries > central_dir_size / 46u)
+    {
+      throw std::runtime_error(std::string(BAD_DIRECTORY_MESG));
+    }
+
+    std::string central_directory(static_cast<size_t>(central_dir_size), '\0');
+    input.seekg(static_cast<std::streamoff>(central_dir_offset));
+    if (central_dir_size > 0u)
+    {
+      input.read(&central_directory[0], static_cast<std::streamsize>(central_dir_size));
+    }
+    if (input.fail())
+    {
+      throw std::runtime_error(std::string(INPUT_FAIL_MESG));
+    }
+
+    size_t pos = 0u;
+    entries.reserve(static_cast<size_t>(total_entries));
+    for (uint64_t jEntry = 0u; jEntry < total_entries; jEntry++)
+    {
+      if (central_directory.size() - pos < 46u ||
+          buffer_to_uint32(&central_directory[pos]) != 0x02014b50u)
+      {
+        throw std::runtime_error(std::string(BAD_DIRECTORY_MESG));
+      }
+
+      const char *record = &central_directory[pos];
+      dirheader_t dirheader;
+      dirheader.signature = buffer_to_uint32(record);
+      dirheader.version_made_by = buffer_to_uint16(record + 4);
+      dirheader.extract_version = buffer_to_uint16(record + 6);
+      dirheader.general_bit_flag = buffer_to_uint16(record + 8);
+      dirheader.compression_method = buffer_to_uint16(record + 10);
+      dirheader.file_mod_timedate.time = buffer_to_uint16(record + 12);
+      dirheader.file_mod_timedate.date = buffer_to_uint16(record + 14);
+      dirheader.crc32 = buffer_to_uint32(record + 16);
+      dirheader.size_compressed = buffer_to_uint32(record + 20);
+      dirheader.size_uncompressed = buffer_to_uint32(record + 24);
+      dirheader.filename_length = buffer_to_uint16(record + 28);
+      dirheader.extra_field_length = buffer_to_uint16(record + 30);
+      dirheader.comment_length = buffer_to_uint16(record + 32);
+      dirheader.disk_number_start = buffer_to_uint16(record + 34);
+      dirheader.internal_attributes = buffer_to_uint16(record + 36);
+      dirheader.external_attributes = buffer_to_uint32(record + 38);
+      dirheader.local_header_offset = buffer_to_uint32(record + 42);
+
+      size_t record_size = 46u + static_cast<size_t>(dirheader.filename_length) +
+                           dirheader.extra_field_length + dirheader.comment_length;
+      if (central_directory.size() - pos < record_size)
+      {
+        throw std::runtime_error(std::string(BAD_DIRECTORY_MESG));
+      }
+
+      dirheader.filename = central_directory.substr(pos + 46u, dirheader.filename_length);
+      entries.push_back(std::move(dirheader));
+      pos += record_size;
+    }
+  }
+
+  /**
+   * Returns the central directory file headers of the archive
+   * in central directory order. The index of a header in this
+   * vector is the index accepted by verifyFile().
+   */
+  const std::vector<dirheader_t>& Reader::getEntries(void) const noexcept
+  {
+    return entries;
+  }
+
+  /**
+   * Opens a new binary input stream on the archive. Each thread
+   * calling verifyFile() should use its own stream.
+   */
+  std::ifstream Reader::openInput(void) const noexcept(false)
+  {
+    std::ifstream input(input_filename, std::ios::binary | std::ios::in);
+    if (!input.is_open())
+    {
+      throw std::runtime_error(std::string(CANNOT_READ_MESG));
+    }
+    return input;
+  }
+
+  /**
+   * verifyFile() checks the local file header of the file at
+   * entries[index] against its central directory file header,
+   * then reads the file contents in blocks and checks their
+   * CRC-32. If output is not null, the contents are also
+   * written to output as they are read.
+   *
+   * Throws std::runtime_error describing the first problem found.
+   */
+  void Reader::verifyFile(const size_t index, std::ifstream &input, std::ostream *output) const noexcept(false)
+  {
+    if (index >= entries.size())
+    {
+      throw std::out_of_range(std::string(BAD_INDEX_MESG));
+    }
+
+    const dirheader_t &dirheader = entries[index];
+    if (dirheader.compression_method != 0u ||
+        dirheader.size_compressed != dirheader.size_uncompressed)
+    {
+      throw std::runtime_error(std::string(UNSUPPORTED_METHOD_MESG));
+    }
+
+    if (static_cast<uint64_t>(dirheader.local_header_offset) + 30u + dirheader.filename_length > file_size)
+    {
+      throw std::runtime_error(std::string(BAD_LOCAL_HEADER_MESG));
+    }
+
+    char header_buffer[30];
+    input.clear();
+    input.seekg(static_cast<std::streamoff>(dirheader.local_header_offset));
+    input.read(header_buffer, 30);
+    std::string local_filename(dirheader.filename_length, '\0');
+    if (dirheader.filename_length > 0u)
+    {
+      input.read(&local_filename[0], dirheader.filename_length);
+    }
+    if (input.fail())
+    {
+      throw std::runtime_error(std::string(INPUT_FAIL_MESG));
+    }
+
+    /**
+     * Bit 3 of the general bit flag means the CRC-32 and sizes
+     * follow the file data in a data descriptor and are zero
+     * in the local header.
+     */
+    uint16_t general_bit_flag = buffer_to_uint16(header_buffer + 6);
+    bool has_descriptor = (general_bit_flag & 0x0008u) != 0u;
+    if (buffer_to_uint32(header_buffer) != 0x04034b50u ||
+        general_bit_flag != dirheader.general_bit_flag ||
+        buffer_to_uint16(header_buffer + 8) != dirheader.compression_method ||
+        buffer_to_uint16(header_buffer + 26) != dirheader.filename_length ||
+        local_filename != dirheader.filename ||
+        (!has_descriptor &&
+         (buffer_to_uint32(header_buffer + 14) != dirheader.crc32 ||
+          buffer_to_uint32(header_buffer + 18) != dirheader.size_compressed ||
+          buffer_to_uint32(header_buffer + 22) != dirheader.size_uncompressed)))
+    {
+      throw std::runtime_error(std::string(BAD_LOCAL_HEADER_MESG));
+    }
+
+    uint64_t data_offset = static_cast<uint64_t>(dirheader.local_header_offset) + 30u +
+                           dirheader.filename_length + buffer_to_uint16(header_buffer + 28);
+    if (data_offset + dirheader.size_compressed > file_size)
+    {
+      throw std::runtime_error(std::string(BAD_LOCAL_HEADER_MESG));
+    }
+    input.seekg(static_cast<std::streamoff>(data_offset));
+
+    const size_t BLOCK_SIZE = 65536u;
+    std::vector<char> block(BLOCK_SIZE);
+    uint32_t remaining = dirheader.size_compressed;
+    uint32_t file_crc32 = 0u;
+    while (remaining > 0u)
+    {
+      size_t this_block = std::min<size_t>(remaining, BLOCK_SIZE);
+      input.read(block.data(), static_cast<std::streamsize>(this_block));
+      if (input.fail())
+      {
+        throw std::runtime_error(std::string(INPUT_FAIL_MESG));
+      }
+      file_crc32 = crc32(file_crc32, block.data(), this_block);
+      if (output != nullptr)
+      {
+        output->write(block.data(), static_cast<std::streamsize>(this_block));
+        if (output->fail())
+        {
+          throw std::runtime_error(std::string(EXTRACT_FAIL_MESG));
+        }
+      }
+      remaining -= static_cast<uint32_t>(this_block);
+    }
+
+    if (file_crc32 != dirheader.crc32)
+    {
+      throw std::runtime_error(std::string(CRC_MISMATCH_MESG));
     }
   }
 }
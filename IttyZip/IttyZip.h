@@ -21,10 +21,15 @@
 #include <string>
 #include <cinttypes>
 #include <fstream>
+#include <ostream>
 #include <utility>
 #include <exception>
 #include <set>
+#include <unordered_set>
 #include <ctime>
+#include <vector>
+#include <memory>
+#include <cstdio>
 
 namespace IttyZip
 {
@@ -38,6 +43,25 @@ namespace IttyZip
   const char OUTPUT_FAIL_MESG[]      = "IttyZip exception: The output stream failed.";
   const char EMPTY_FINALIZE_MESG[]   = "IttyZip::finalize() was called on an empty IttyZip object.";
   const char DUPLICATE_FILE_MESG[]   = "IttyZip::addFile() was called twice with the same filename.";
+  const char TOO_LARGE_MESG[]        = "IttyZip::addFile() would grow the archive past the 4 GiB limit of 32 bit ZIP offsets.";
+  const char SPILL_FAIL_MESG[]       = "IttyZip exception: The temporary central directory file failed.";
+  const char ENTRY_OPEN_MESG[]       = "IttyZip::beginFile() left a file open; call endFile() before adding another file or calling finalize().";
+  const char NO_ENTRY_MESG[]         = "IttyZip::writeFileData() or endFile() called without a file opened by beginFile().";
+  const char SEEK_FAIL_MESG[]        = "IttyZip::endFile() could not seek back to complete the local file header.";
+  const char LATE_SPILL_MESG[]       = "IttyZip::setSpillThreshold() was called after files were added to the archive.";
+
+  /**
+   * Messages for the "what()" in exceptions thrown by IttyZip::Reader
+   */
+  const char CANNOT_READ_MESG[]        = "IttyZip::Reader cannot open the input file for reading.";
+  const char INPUT_FAIL_MESG[]         = "IttyZip::Reader exception: The input stream failed.";
+  const char NO_END_RECORD_MESG[]      = "IttyZip::Reader could not find an end of central directory record.";
+  const char BAD_DIRECTORY_MESG[]      = "IttyZip::Reader found a malformed central directory.";
+  const char BAD_INDEX_MESG[]          = "IttyZip::Reader::verifyFile() received an out of range file index.";
+  const char BAD_LOCAL_HEADER_MESG[]   = "IttyZip::Reader found a local file header that does not match the central directory.";
+  const char UNSUPPORTED_METHOD_MESG[] = "IttyZip::Reader can only verify stored (uncompressed) files.";
+  const char CRC_MISMATCH_MESG[]       = "IttyZip::Reader computed a CRC-32 that does not match the central directory.";
+  const char EXTRACT_FAIL_MESG[]       = "IttyZip::Reader exception: Writing an extracted file failed.";
 
   /**
    * Struct to hold a standard DOS format time + date stamp.
@@ -109,12 +133,66 @@ namespace IttyZip
     uint16_t comment_length;
   } endrecord_t;
 
+  /**
+   * Counters for a single file in an IttyZip archive.
+   * Times are in nanoseconds. header_ns covers the serialization
+   * of the local and central directory file headers; write_ns and
+   * write_calls cover every write of the file's header and contents
+   * to the output stream.
+   */
+  typedef struct
+  {
+    std::string filename;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint64_t checksum_ns;
+    uint64_t header_ns;
+    uint64_t write_ns;
+    uint64_t write_calls;
+  } entrystats_t;
+
+  /**
+   * Counters for a whole IttyZip archive. The archive totals also
+   * include the central directory and the end of central directory
+   * record written by finalize().
+   *
+   * Statistics are only collected if IttyZip is compiled with
+   * ITTYZIP_STATS defined. Otherwise all counting code is compiled
+   * out and IttyZip::getStats() returns an empty zipstats_t.
+   *
+   * entries holds one record per file, except when a spill
+   * threshold is set (see IttyZip::setSpillThreshold()): then only
+   * the archive totals are kept, so that they take no memory per
+   * file.
+   */
+  typedef struct
+  {
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint64_t checksum_ns;
+    uint64_t header_ns;
+    uint64_t write_ns;
+    uint64_t write_calls;
+    std::vector<entrystats_t> entries;
+  } zipstats_t;
+
+  /**
+   * Deleter that lets a std::unique_ptr own a C stdio file.
+   */
+  struct file_closer
+  {
+    void operator() (std::FILE *file) const noexcept;
+  };
+
   std::tm localtime_locked(const std::time_t &timepoint) noexcept;
   std::tm gmtime_locked(const std::time_t &timepoint) noexcept;
   dostimedate_t dosTimeDate(void) noexcept;
   uint32_t crc32(const std::string &data) noexcept;
+  uint32_t crc32(const uint32_t crc, const char *data, const size_t length) noexcept;
   void uint16_to_buffer(const uint16_t in, char *out) noexcept;
   void uint32_to_buffer(const uint32_t in, char *out) noexcept;
+  uint16_t buffer_to_uint16(const char *in) noexcept;
+  uint32_t buffer_to_uint32(const char *in) noexcept;
 
   class IttyZip 
   {
@@ -123,19 +201,37 @@ namespace IttyZip
     IttyZip(const std::string &outputFilename) noexcept(false);
     void open(const std::string &outputFilename) noexcept(false);
     void addFile(const std::string &filename, const std::string &contents) noexcept(false);
+    void addFile(const std::string &filename, const char *contents, const size_t length) noexcept(false);
+    void beginFile(const std::string &filename) noexcept(false);
+    void writeFileData(const char *data, const size_t length) noexcept(false);
+    void writeFileData(const std::string &data) noexcept(false);
+    void endFile(void) noexcept(false);
     void finalize(void) noexcept(false);
+    void discard(void) noexcept;
+    void setSpillThreshold(const size_t threshold, const bool check_duplicates = false) noexcept(false);
+    const zipstats_t& getStats(void) const noexcept;
 
   private:
     std::pair<localheader_t, dirheader_t> generateHeaders(const std::string &filename, const uint32_t file_size, const uint32_t file_crc32) const noexcept;
     uint32_t writeLocalheader(const localheader_t &localheader) noexcept(false);
+    void writeBytes(const char *data, const size_t length) noexcept;
+    bool rememberFilename(const std::string &filename) noexcept(false);
     void storeDirheader(const dirheader_t &dirheader) noexcept;
+    void appendDirheader(const size_t index, std::string &buffer) const noexcept;
+    size_t directorySize(void) const noexcept;
+    void clearDirectory(void) noexcept;
+    void emitDirectory(const bool to_spill_file) noexcept(false);
     endrecord_t generateEndRecord(void) const noexcept;
     void writeEndRecord(const endrecord_t &end_record) noexcept(false);
+    void writeZip64EndRecord(const uint64_t central_dir_size, const uint64_t central_dir_offset) noexcept(false);
+    void spillDirectory(void) noexcept(false);
 
     /**
      * The number of files already stored in this IttyZip archive.
+     * Archives with more than 65535 files get ZIP64 end of central
+     * directory records.
      */
-    uint16_t num_files;
+    uint32_t num_files;
 
     /**
      * An ofstream for writing to the output ZIP file.
@@ -161,15 +257,116 @@ namespace IttyZip
     /**
      * Temporary storage for the ZIP archive central directory,
      * since this part of the file is written at the very end.
+     * Only the fields that vary from file to file are kept, in
+     * parallel arrays indexed by file: about 20 bytes per file
+     * plus its filename. dir_timedates packs the DOS time in the
+     * low and the DOS date in the high 16 bits. dir_name_offsets
+     * locates each filename within dir_names, where the names
+     * are packed back to back.
      */
-    std::string central_directory;
+    std::vector<uint32_t> dir_crc32s;
+    std::vector<uint32_t> dir_sizes;
+    std::vector<uint32_t> dir_offsets;
+    std::vector<uint32_t> dir_timedates;
+    std::vector<uint32_t> dir_name_offsets;
+    std::string dir_names;
+
+    /**
+     * Buffer in which emitDirectory() serializes the central
+     * directory, kept from one archive to the next.
+     */
+    std::string dir_block;
 
     /**
      * Set containing the full filenames of all files previously
      * added to the IttyZip archive. Purely used to check for
-     * duplicate files.
+     * duplicate files. Left empty when spill_threshold is nonzero;
+     * if spill_duplicate_check is set, filename_hashes then holds a
+     * 64 bit hash of each filename instead, at about 40 bytes per
+     * file however long its name. Otherwise filenames are not
+     * checked while spilling.
      */
     std::set<std::string> filenames;
+    std::unordered_set<uint64_t> filename_hashes;
+    bool spill_duplicate_check;
+
+    /**
+     * True between beginFile() and endFile(), while a file is
+     * being streamed into the archive. entry_headers holds that
+     * file's headers; its central directory header accumulates
+     * the CRC-32 and size of the data written so far.
+     */
+    bool entry_open;
+    std::pair<localheader_t, dirheader_t> entry_headers;
+
+    /**
+     * When nonzero, the in-memory central directory is moved out
+     * to spill_file each time its serialized size reaches at least
+     * this many bytes, so the central directory no longer takes
+     * memory per file in the archive.
+     * Set with setSpillThreshold().
+     */
+    size_t spill_threshold;
+
+    /**
+     * Anonymous temporary file holding the part of the central
+     * directory spilled so far, and that part's size in bytes.
+     * finalize() copies it to the output ahead of whatever is
+     * still held in memory.
+     */
+    std::unique_ptr<std::FILE, file_closer> spill_file;
+    uint64_t spilled_size;
+
+    /**
+     * Counters for the archive being written, or for the last
+     * archive finalized. Cleared by open(). Declared whether or
+     * not ITTYZIP_STATS is defined, so that the layout of IttyZip
+     * does not depend on it; without it they stay empty.
+     */
+    zipstats_t stats;
+
+    /**
+     * Counters for the file being streamed between beginFile()
+     * and endFile().
+     */
+    entrystats_t entry_stats;
+  };
+
+  /**
+   * Reader parses the central directory of an existing ZIP
+   * archive and verifies (and optionally extracts) the files in
+   * it. Only stored files can be verified, which covers every
+   * archive written by IttyZip.
+   *
+   * Once constructed, a Reader is never modified, so verifyFile()
+   * may be called from several threads at once as long as each
+   * thread uses its own input stream from openInput().
+   */
+  class Reader
+  {
+  public:
+    Reader(const std::string &inputFilename) noexcept(false);
+    const std::vector<dirheader_t>& getEntries(void) const noexcept;
+    std::ifstream openInput(void) const noexcept(false);
+    void verifyFile(const size_t index, std::ifstream &input, std::ostream *output = nullptr) const noexcept(false);
+
+  private:
+    /**
+     * Name of the archive file, kept so that openInput() can
+     * open further streams on it.
+     */
+    std::string input_filename;
+
+    /**
+     * Total size of the archive file in bytes.
+     */
+    uint64_t file_size;
+
+    /**
+     * The central directory file headers of the archive, in
+     * the order they appear in the central directory.
+     */
+    std::vector<dirheader_t> entries;
   };
 }
 
@@ -0,0 +1,408 @@
+/**
+ * IttyZipBench.cpp
+ *
+ * Throughput benchmark for the IttyZip class. Writes archives across a
+ * sweep of entry sizes, entry counts, output sinks, and compression
+ * modes, and prints the results as JSON on stdout so that runs from
+ * different commits on the same machine can be compared directly.
+ *
+ * Usage: IttyZipBench [--max-size bytes] [--max-count entries]
+ *                     [--max-total bytes] [--reps n] [--sink file|null|all]
+ *                     [--spill bytes]
+ *
+ * Written in 2019 by Ben Tesch.
+ * Originally distributed at https://github.com/slugrustle/office_open_xml
+ * 
+ * To the extent possible under law, the author has dedicated all copyright
+ * and related and neighboring rights to this software to the public domain
+ * worldwide. This software is distributed without any warranty.
+ * The text of the CC0 Public Domain Dedication should be reproduced at the
+ * end of this file. If not, see http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "IttyZip.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <exception>
+
+/**
+ * Entry sizes and entry counts swept by the benchmark.
+ * Cases whose total payload exceeds max_total are skipped,
+ * with the exception of single entry cases, so that the
+ * largest entry size is always measured.
+ */
+static const uint64_t ENTRY_SIZES[] = {64u, 1024u, 16384u, 262144u, 4194304u, 67108864u, 1073741824u};
+static const uint64_t ENTRY_COUNTS[] = {1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u};
+
+/**
+ * Only stored (uncompressed) entries are supported by IttyZip;
+ * the mode is still reported so that results remain comparable
+ * should further modes be added.
+ */
+static const char *COMPRESSION_MODES[] = {"store"};
+
+#ifdef _WIN32
+static const char NULL_SINK[] = "NUL";
+#else
+static const char NULL_SINK[] = "/dev/null";
+#endif
+static const char FILE_SINK[] = "IttyZipBench.zip";
+
+/**
+ * Settings that may be overridden on the command line.
+ */
+typedef struct
+{
+  uint64_t max_size;
+  uint64_t max_count;
+  uint64_t max_total;
+  uint64_t spill_threshold;
+  uint32_t reps;
+  bool file_sink;
+  bool null_sink;
+} bench_config_t;
+
+/**
+ * Result of a single benchmark case. seconds is the best
+ * (smallest) time over all repetitions.
+ */
+typedef struct
+{
+  const char *sink;
+  const char *compression;
+  uint64_t entry_size;
+  uint64_t entry_count;
+  double seconds;
+} bench_result_t;
+
+/**
+ * Writes one archive with entry_count entries of entry_size
+ * bytes each to output_path and returns the elapsed time in
+ * seconds, including finalize().
+ */
+static double run_case(const std::string &output_path, const std::string &contents, const uint64_t entry_count, const uint64_t spill_threshold) noexcept(false)
+{
+  std::vector<std::string> names;
+  names.reserve(static_cast<size_t>(entry_count));
+  for (uint64_t jEntry = 0u; jEntry < entry_count; jEntry++)
+  {
+    names.push_back("bench/entry" + std::to_string(jEntry) + ".bin");
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  IttyZip::IttyZip zip(output_path);
+  zip.setSpillThreshold(static_cast<size_t>(spill_threshold));
+  for (uint64_t jEntry = 0u; jEntry < entry_count; jEntry++)
+  {
+    zip.addFile(names.at(static_cast<size_t>(jEntry)), contents);
+  }
+  zip.finalize();
+  std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double>(stop - start).count();
+}
+
+/**
+ * Parses a non-negative integer command line value.
+ */
+static bool parse_u64(const char *text, uint64_t &value) noexcept
+{
+  char *end = nullptr;
+  unsigned long long parsed = std::strtoull(text, &end, 10);
+  if (end == text || *end != '\0')
+  {
+    return false;
+  }
+  value = static_cast<uint64_t>(parsed);
+  return true;
+}
+
+static bool parse_args(int argc, char **argv, bench_config_t &config) noexcept
+{
+  for (int jArg = 1; jArg < argc; jArg++)
+  {
+    if (jArg + 1 >= argc)
+    {
+      return false;
+    }
+
+    const char *option = argv[jArg];
+    const char *value = argv[++jArg];
+    uint64_t number = 0u;
+
+    if (std::strcmp(option, "--sink") == 0)
+    {
+      config.file_sink = (std::strcmp(value, "file") == 0 || std::strcmp(value, "all") == 0);
+      config.null_sink = (std::strcmp(value, "null") == 0 || std::strcmp(value, "all") == 0);
+      if (!config.file_sink && !config.null_sink)
+      {
+        return false;
+      }
+    }
+    else if (!parse_u64(value, number))
+    {
+      return false;
+    }
+    else if (std::strcmp(option, "--max-size") == 0)
+    {
+      config.max_size = number;
+    }
+    else if (std::strcmp(option, "--max-count") == 0)
+    {
+      config.max_count = number;
+    }
+    else if (std::strcmp(option, "--max-total") == 0)
+    {
+      config.max_total = number;
+    }
+    else if (std::strcmp(option, "--spill") == 0)
+    {
+      config.spill_threshold = number;
+    }
+    else if (std::strcmp(option, "--reps") == 0 && number > 0u)
+    {
+      config.reps = static_cast<uint32_t>(number);
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  bench_config_t config;
+  config.max_size = 1073741824u;
+  config.max_count = 1000000u;
+  config.max_total = 1073741824u;
+  config.spill_threshold = 0u;
+  config.reps = 3u;
+  config.file_sink = true;
+  config.null_sink = true;
+
+  if (!parse_args(argc, argv, config))
+  {
+    std::fprintf(stderr, "Usage: %s [--max-size bytes] [--max-count entries] [--max-total bytes] [--reps n] [--sink file|null|all] [--spill bytes]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::pair<const char *, std::string> > sinks;
+  if (config.file_sink)
+  {
+    sinks.push_back(std::make_pair("file", std::string(FILE_SINK)));
+  }
+  if (config.null_sink)
+  {
+    sinks.push_back(std::make_pair("null", std::string(NULL_SINK)));
+  }
+
+  std::vector<bench_result_t> results;
+
+  try
+  {
+    for (const uint64_t entry_size : ENTRY_SIZES)
+    {
+      if (entry_size > config.max_size)
+      {
+        continue;
+      }
+
+      std::string contents(static_cast<size_t>(entry_size), '\0');
+      for (size_t jChar = 0u; jChar < contents.size(); jChar++)
+      {
+        contents[jChar] = static_cast<char>('A' + (jChar * 7u) % 26u);
+      }
+
+      for (const uint64_t entry_count : ENTRY_COUNTS)
+      {
+        if (entry_count > config.max_count ||
+            (entry_count > 1u && entry_size * entry_count > config.max_total))
+        {
+          continue;
+        }
+
+        for (const char *compression : COMPRESSION_MODES)
+        {
+          for (const std::pair<const char *, std::string> &sink : sinks)
+          {
+            bench_result_t result;
+            result.sink = sink.first;
+            result.compression = compression;
+            result.entry_size = entry_size;
+            result.entry_count = entry_count;
+            result.seconds = 0.0;
+
+            for (uint32_t jRep = 0u; jRep < config.reps; jRep++)
+            {
+              double seconds = run_case(sink.second, contents, entry_count, config.spill_threshold);
+              if (jRep == 0u || seconds < result.seconds)
+              {
+                result.seconds = seconds;
+              }
+            }
+
+            std::fprintf(stderr, "%s %s size=%llu count=%llu %.6f s\n", result.sink, result.compression,
+                         static_cast<unsigned long long>(entry_size), static_cast<unsigned long long>(entry_count), result.seconds);
+            results.push_back(result);
+          }
+        }
+      }
+    }
+  }
+  catch (std::exception &e)
+  {
+    std::remove(FILE_SINK);
+    std::fprintf(stderr, "Benchmark failed.\n%s\n\n", e.what());
+    return EXIT_FAILURE;
+  }
+
+  std::remove(FILE_SINK);
+
+  std::printf("{\n  \"benchmark\": \"IttyZip\",\n  \"reps\": %u,\n  \"spill_threshold\": %llu,\n  \"results\": [",
+              config.reps, static_cast<unsigned long long>(config.spill_threshold));
+  for (size_t jResult = 0u; jResult < results.size(); jResult++)
+  {
+    const bench_result_t &result = results.at(jResult);
+    double total_bytes = static_cast<double>(result.entry_size) * static_cast<double>(result.entry_count);
+    double seconds = (result.seconds > 0.0 ? result.seconds : 1.0e-9);
+    std::printf("%s\n    {\"sink\": \"%s\", \"compression\": \"%s\", \"entry_size\": %llu, \"entry_count\": %llu, "
+                "\"seconds\": %.9f, \"entries_per_sec\": %.3f, \"mb_per_sec\": %.3f}",
+                (jResult == 0u ? "" : ","), result.sink, result.compression,
+                static_cast<unsigned long long>(result.entry_size), static_cast<unsigned long long>(result.entry_count),
+                result.seconds, static_cast<double>(result.entry_count) / seconds, total_bytes / seconds / 1.0e6);
+  }
+  std::printf("\n  ]\n}\n");
+
+  return EXIT_SUCCESS;
+}
+
+/*
+Creative Commons Legal Code
+
+CC0 1.0 Universal
+
+    CREATIVE COMMONS CORPORATION IS NOT A LAW FIRM AND DOES NOT PROVIDE
+    LEGAL SERVICES. DISTRIBUTION OF THIS DOCUMENT DOES NOT CREATE AN
+    ATTORNEY-CLIENT RELATIONSHIP. CREATIVE COMMONS PROVIDES THIS
+    INFORMATION ON AN "AS-IS" BASIS. CREATIVE COMMONS MAKES NO WARRANTIES
+    REGARDING THE USE OF THIS DOCUMENT OR THE INFORMATION OR WORKS
+    PROVIDED HEREUNDER, AND DISCLAIMS LIABILITY FOR DAMAGES RESULTING FROM
+    THE USE OF THIS DOCUMENT OR THE INFORMATION OR WORKS PROVIDED
+    HEREUNDER.
+
+Statement of Purpose
+
+The laws of most jurisdictions throughout the world automatically confer
+exclusive Copyright and Related Rights (defined below) upon the creator
+and subsequent owner(s) (each and all, an "owner") of an original work of
+authorship and/or a database (each, a "Work").
+
+Certain owners wish to permanently relinquish those rights to a Work for
+the purpose of contributing to a commons of creative, cultural and
+scientific works ("Commons") that the public can reliably and without fear
+of later claims of infringement build upon, modify, incorporate in other
+works, reuse and redistribute as freely as possible in any form whatsoever
+and for any purposes, including without limitation commercial purposes.
+These owners may contribute to the Commons to promote the ideal of a free
+culture and the further production of creative, cultural and scientific
+works, or to gain reputation or greater distribution for their Work in
+part through the use and efforts of others.
+
+For these and/or other purposes and motivations, and without any
+expectation of additional consideration or compensation, the person
+associating CC0 with a Work (the "Affirmer"), to the extent that he or she
+is an owner of Copyright and Related Rights in the Work, voluntarily
+elects to apply CC0 to the Work and publicly distribute the Work under its
+terms, with knowledge of his or her Copyright and Related Rights in the
+Work and the meaning and intended legal effect of CC0 on those rights.
+
+1. Copyright and Related Rights. A Work made available under CC0 may be
+protected by copyright and related or neighboring rights ("Copyright and
+Related Rights"). Copyright and Related Rights include, but are not
+limited to, the following:
+
+  i. the right to reproduce, adapt, distribute, perform, display,
+     communicate, and translate a Work;
+ ii. moral rights retained by the original author(s) and/or performer(s);
+iii. publicity and privacy rights pertaining to a person's image or
+     likeness depicted in a Work;
+ iv. rights protecting against unfair competition in regards to a Work,
+     subject to the limitations in paragraph 4(a), below;
+  v. rights protecting the extraction, dissemination, use and reuse of data
+     in a Work;
+ vi. database rights (such as those arising under Directive 96/9/EC of the
+     European Parliament and of the Council of 11 March 1996 on the legal
+     protection of databases, and under any national implementation
+     thereof, including any amended or successor version of such
+     directive); and
+vii. other similar, equivalent or corresponding rights throughout the
+     world based on applicable law or treaty, and any national
+     implementations thereof.
+
+2. Waiver. To the greatest extent permitted by, but not in contravention
+of, applicable law, Affirmer hereby overtly, fully, permanently,
+irrevocably and unconditionally waives, abandons, and surrenders all of
+Affirmer's Copyright and Related Rights and associated claims and causes
+of action, whether now known or unknown (including existing as well as
+future claims and causes of action), in the Work (i) in all territories
+worldwide, (ii) for the maximum duration provided by applicable law or
+treaty (including future time extensions), (iii) in any current or future
+medium and for any number of copies, and (iv) for any purpose whatsoever,
+including without limitation commercial, advertising or promotional
+purposes (the "Waiver"). Affirmer makes the Waiver for the benefit of each
+member of the public at large and to the detriment of Affirmer's heirs and
+successors, fully intending that such Waiver shall not be subject to
+revocation, rescission, cancellation, termination, or any other legal or
+equitable action to disrupt the quiet enjoyment of the Work by the public
+as contemplated by Affirmer's express Statement of Purpose.
+
+3. Public License Fallback. Should any part of the Waiver for any reason
+be judged legally invalid or ineffective under applicable law, then the
+Waiver shall be preserved to the maximum extent permitted taking into
+account Affirmer's express Statement of Purpose. In addition, to the
+extent the Waiver is so judged Affirmer hereby grants to each affected
+person a royalty-free, non transferable, non sublicensable, non exclusive,
+irrevocable and unconditional license to exercise Affirmer's Copyright and
+Related Rights in the Work (i) in all territories worldwide, (ii) for the
+maximum duration provided by applicable law or treaty (including future
+time extensions), (iii) in any current or future medium and for any number
+of copies, and (iv) for any purpose whatsoever, including without
+limitation commercial, advertising or promotional purposes (the
+"License"). The License shall be deemed effective as of the date CC0 was
+applied by Affirmer to the Work. Should any part of the License for any
+reason be judged legally invalid or ineffective under applicable law, such
+partial invalidity or ineffectiveness shall not invalidate the remainder
+of the License, and in such case Affirmer hereby affirms that he or she
+will not (i) exercise any of his or her remaining Copyright and Related
+Rights in the Work or (ii) assert any associated claims and causes of
+action with respect to the Work, in either case contrary to Affirmer's
+express Statement of Purpose.
+
+4. Limitations and Disclaimers.
+
+ a. No trademark or patent rights held by Affirmer are waived, abandoned,
+    surrendered, licensed or otherwise affected by this document.
+ b. Affirmer offers the Work as-is and makes no representations or
+    warranties of any kind concerning the Work, express, implied,
+    statutory or otherwise, including without limitation warranties of
+    title, merchantability, fitness for a particular purpose, non
+    infringement, or the absence of latent or other defects, accuracy, or
+    the present or absence of errors, whether or not discoverable, all to
+    the greatest extent permissible under applicable law.
+ c. Affirmer disclaims responsibility for clearing rights of other persons
+    that may apply to the Work or any use thereof, including without
+    limitation any person's Copyright and Related Rights in the Work.
+    Further, Affirmer disclaims responsibility for obtaining any necessary
+    consents, permissions or other rights required for any use of the
+    Work.
+ d. Affirmer understands and acknowledges that Creative Commons is not a
+    party to this document and has no duty or obligation with respect to
+    this CC0 or use of the Work.
+*/
@@ -0,0 +1,431 @@
+/**
+ * IttyZipVerify.cpp
+ *
+ * Command line tool that verifies ZIP archives with IttyZip::Reader.
+ * Every local file header is checked against the central directory
+ * and every file's CRC-32 is recomputed, spread across a pool of
+ * threads. Files may optionally be extracted at the same time.
+ *
+ * Usage: IttyZipVerify [-j threads] [-x output_directory] [-q] archive.zip [...]
+ *
+ * Exit codes, suited to batch use:
+ *   0  every file in every archive verified
+ *   1  at least one file failed verification or extraction
+ *   2  bad usage, an archive could not be opened or parsed, or the
+ *      output directory could not be created
+ *
+ * Written in 2019 by Ben Tesch.
+ * Originally distributed at https://github.com/slugrustle/office_open_xml
+ * 
+ * To the extent possible under law, the author has dedicated all copyright
+ * and related and neighboring rights to this software to the public domain
+ * worldwide. This software is distributed without any warranty.
+ * The text of the CC0 Public Domain Dedication should be reproduced at the
+ * end of this file. If not, see http://creativecommons.org/publicdomain/zero/1.0/
+ */
+
+#include "IttyZip.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <exception>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+const int EXIT_VERIFIED = 0;
+const int EXIT_BAD_FILE = 1;
+const int EXIT_BAD_ARCHIVE = 2;
+
+/**
+ * Creates the directory path if it does not already exist.
+ * Returns false on any error other than the directory existing.
+ */
+static bool make_directory(const std::string &path) noexcept
+{
+#ifdef _WIN32
+  int retval = _mkdir(path.c_str());
+#else
+  int retval = mkdir(path.c_str(), 0777);
+#endif
+  return retval == 0 || errno == EEXIST;
+}
+
+/**
+ * Rejects archive member names that would be extracted outside
+ * the output directory: absolute paths, drive letters, and any
+ * ".." path component.
+ */
+static bool safe_member_name(const std::string &name) noexcept
+{
+  if (name.empty() || name[0] == '/' || name[0] == '\\' || name.find(':') != std::string::npos)
+  {
+    return false;
+  }
+
+  size_t component_start = 0u;
+  for (size_t jChar = 0u; jChar <= name.size(); jChar++)
+  {
+    if (jChar == name.size() || name[jChar] == '/' || name[jChar] == '\\')
+    {
+      if (name.compare(component_start, jChar - component_start, "..") == 0)
+      {
+        return false;
+      }
+      component_start = jChar + 1u;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Creates every parent directory of the member name
+ * underneath output_directory.
+ */
+static bool make_parent_directories(const std::string &output_directory, const std::string &name) noexcept
+{
+  for (size_t jChar = 0u; jChar < name.size(); jChar++)
+  {
+    if (name[jChar] == '/' && jChar > 0u)
+    {
+      if (!make_directory(output_directory + "/" + name.substr(0u, jChar)))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Verifies (and extracts, if output_directory is not empty) every
+ * file in archive_name using up to num_threads threads. Problems
+ * are printed to stdout. Returns one of the exit codes above.
+ */
+static int verify_archive(const std::string &archive_name, const std::string &output_directory, const unsigned num_threads, const bool quiet)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  try
+  {
+    const IttyZip::Reader reader(archive_name);
+    const std::vector<IttyZip::dirheader_t> &entries = reader.getEntries();
+
+    std::atomic<size_t> next_index(0u);
+    std::atomic<uint64_t> total_bytes(0u);
+    std::atomic<size_t> failures(0u);
+    std::mutex print_mutex;
+
+    auto worker = [&]()
+    {
+      std::ifstream input;
+      try
+      {
+        input = reader.openInput();
+      }
+      catch (std::exception &e)
+      {
+        std::lock_guard<std::mutex> print_lock(print_mutex);
+        std::printf("%s: %s\n", archive_name.c_str(), e.what());
+        failures++;
+        return;
+      }
+
+      for (size_t index = next_index++; index < entries.size(); index = next_index++)
+      {
+        const IttyZip::dirheader_t &entry = entries[index];
+        try
+        {
+          if (output_directory.empty())
+          {
+            reader.verifyFile(index, input);
+          }
+          else
+          {
+            if (!safe_member_name(entry.filename))
+            {
+              throw std::runtime_error(std::string("unsafe file name; not extracted."));
+            }
+            if (!make_parent_directories(output_directory, entry.filename))
+            {
+              throw std::runtime_error(std::string("could not create output directory."));
+            }
+
+            std::string output_name = output_directory + "/" + entry.filename;
+            if (entry.filename.back() == '/')
+            {
+              if (!make_directory(output_name))
+              {
+                throw std::runtime_error(std::string("could not create output directory."));
+              }
+              reader.verifyFile(index, input);
+            }
+            else
+            {
+              std::ofstream output(output_name, std::ios::binary | std::ios::out | std::ios::trunc);
+              if (!output.is_open())
+              {
+                throw std::runtime_error(std::string("could not open output file."));
+              }
+              reader.verifyFile(index, input, &output);
+            }
+          }
+          total_bytes += entry.size_uncompressed;
+        }
+        catch (std::exception &e)
+        {
+          std::lock_guard<std::mutex> print_lock(print_mutex);
+          std::printf("%s: %s: %s\n", archive_name.c_str(), entry.filename.c_str(), e.what());
+          failures++;
+        }
+      }
+    };
+
+    if (!output_directory.empty() && !make_directory(output_directory))
+    {
+      std::printf("%s: could not create output directory %s.\n", archive_name.c_str(), output_directory.c_str());
+      return EXIT_BAD_ARCHIVE;
+    }
+
+    size_t pool_size = std::max<size_t>(1u, std::min<size_t>(num_threads, entries.size()));
+    std::vector<std::thread> pool;
+    for (size_t jThread = 1u; jThread < pool_size; jThread++)
+    {
+      pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : pool)
+    {
+      thread.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (failures > 0u)
+    {
+      std::printf("%s: FAILED, %zu of %zu files, %.6f s\n", archive_name.c_str(), failures.load(), entries.size(), seconds);
+      return EXIT_BAD_FILE;
+    }
+
+    if (!quiet)
+    {
+      std::printf("%s: OK, %zu files, %llu bytes, %.6f s, %.3f MB/s\n", archive_name.c_str(), entries.size(),
+                  static_cast<unsigned long long>(total_bytes.load()), seconds,
+                  (seconds > 0.0 ? static_cast<double>(total_bytes.load()) / seconds / 1.0e6 : 0.0));
+    }
+    return EXIT_VERIFIED;
+  }
+  catch (std::exception &e)
+  {
+    std::printf("%s: %s\n", archive_name.c_str(), e.what());
+    return EXIT_BAD_ARCHIVE;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  unsigned num_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::string output_directory;
+  bool quiet = false;
+  std::vector<std::string> archives;
+  bool bad_usage = false;
+
+  for (int jArg = 1; jArg < argc; jArg++)
+  {
+    if (std::strcmp(argv[jArg], "-j") == 0)
+    {
+      if (jArg + 1 >= argc)
+      {
+        bad_usage = true;
+        break;
+      }
+      const char *value = argv[++jArg];
+      char *value_end = nullptr;
+      errno = 0;
+      long parsed = std::strtol(value, &value_end, 10);
+      if (value_end == value || *value_end != '\0' || errno == ERANGE || parsed < 1 || parsed > 65535)
+      {
+        bad_usage = true;
+        break;
+      }
+      num_threads = static_cast<unsigned>(parsed);
+    }
+    else if (std::strcmp(argv[jArg], "-x") == 0)
+    {
+      if (jArg + 1 >= argc)
+      {
+        bad_usage = true;
+        break;
+      }
+      output_directory = argv[++jArg];
+    }
+    else if (std::strcmp(argv[jArg], "-q") == 0)
+    {
+      quiet = true;
+    }
+    else if (argv[jArg][0] == '-')
+    {
+      bad_usage = true;
+      break;
+    }
+    else
+    {
+      archives.push_back(argv[jArg]);
+    }
+  }
+
+  if (bad_usage || archives.empty())
+  {
+    std::fprintf(stderr, "Usage: %s [-j threads] [-x output_directory] [-q] archive.zip [...]\n", argv[0]);
+    return EXIT_BAD_ARCHIVE;
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int exit_code = EXIT_VERIFIED;
+  for (const std::string &archive_name : archives)
+  {
+    exit_code = std::max(exit_code, verify_archive(archive_name, output_directory, num_threads, quiet));
+  }
+
+  if (archives.size() > 1u && !quiet)
+  {
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%zu archives, %.6f s\n", archives.size(), seconds);
+  }
+
+  return exit_code;
+}
+
+/*
+Creative Commons Legal Code
+
+CC0 1.0 Universal
+
+    CREATIVE COMMONS CORPORATION IS NOT A LAW FIRM AND DOES NOT PROVIDE
+    LEGAL SERVICES. DISTRIBUTION OF THIS DOCUMENT DOES NOT CREATE AN
+    ATTORNEY-CLIENT RELATIONSHIP. CREATIVE COMMONS PROVIDES THIS
+    INFORMATION ON AN "AS-IS" BASIS. CREATIVE COMMONS MAKES NO WARRANTIES
+    REGARDING THE USE OF THIS DOCUMENT OR THE INFORMATION OR WORKS
+    PROVIDED HEREUNDER, AND DISCLAIMS LIABILITY FOR DAMAGES RESULTING FROM
+    THE USE OF THIS DOCUMENT OR THE INFORMATION OR WORKS PROVIDED
+    HEREUNDER.
+
+Statement of Purpose
+
+The laws of most jurisdictions throughout the world automatically confer
+exclusive Copyright and Related Rights (defined below) upon the creator
+and subsequent owner(s) (each and all, an "owner") of an original work of
+authorship and/or a database (each, a "Work").
+
+Certain owners wish to permanently relinquish those rights to a Work for
+the purpose of contributing to a commons of creative, cultural and
+scientific works ("Commons") that the public can reliably and without fear
+of later claims of infringement build upon, modify, incorporate in other
+works, reuse and redistribute as freely as possible in any form whatsoever
+and for any purposes, including without limitation commercial purposes.
+These owners may contribute to the Commons to promote the ideal of a free
+culture and the further production of creative, cultural and scientific
+works, or to gain reputation or greater distribution for their Work in
+part through the use and efforts of others.
+
+For these and/or other purposes and motivations, and without any
+expectation of additional consideration or compensation, the person
+associating CC0 with a Work (the "Affirmer"), to the extent that he or she
+is an owner of Copyright and Related Rights in the Work, voluntarily
+elects to apply CC0 to the Work and publicly distribute the Work under its
+terms, with knowledge of his or her Copyright and Related Rights in the
+Work and the meaning and intended legal effect of CC0 on those rights.
+
+1. Copyright and Related Rights. A Work made available under CC0 may be
+protected by copyright and related or neighboring rights ("Copyright and
+Related Rights"). Copyright and Related Rights include, but are not
+limited to, the following:
+
+  i. the right to reproduce, adapt, distribute, perform, display,
+     communicate, and translate a Work;
+ ii. moral rights retained by the original author(s) and/or performer(s);
+iii. publicity and privacy rights pertaining to a person's image or
+     likeness depicted in a Work;
+ iv. rights protecting against unfair competition in regards to a Work,
+     subject to the limitations in paragraph 4(a), below;
+  v. rights protecting the extraction, dissemination, use and reuse of data
+     in a Work;
+ vi. database rights (such as those arising under Directive 96/9/EC of the
+     European Parliament and of the Council of 11 March 1996 on the legal
+     protection of databases, and under any national implementation
+     thereof, including any amended or successor version of such
+     directive); and
+vii. other similar, equivalent or corresponding rights throughout the
+     world based on applicable law or treaty, and any national
+     implementations thereof.
+
+2. Waiver. To the greatest extent permitted by, but not in contravention
+of, applicable law, Affirmer hereby overtly, fully, permanently,
+irrevocably and unconditionally waives, abandons, and surrenders all of
+Affirmer's Copyright and Related Rights and associated claims and causes
+of action, whether now known or unknown (including existing as well as
+future claims and causes of action), in the Work (i) in all territories
+worldwide, (ii) for the maximum duration provided by applicable law or
+treaty (including future time extensions), (iii) in any current or future
+medium and for any number of copies, and (iv) for any purpose whatsoever,
+including without limitation commercial, advertising or promotional
+purposes (the "Waiver"). Affirmer makes the Waiver for the benefit of each
+member of the public at large and to the detriment of Affirmer's heirs and
+successors, fully intending that such Waiver shall not be subject to
+revocation, rescission, cancellation, termination, or any other legal or
+equitable action to disrupt the quiet enjoyment of the Work by the public
+as contemplated by Affirmer's express Statement of Purpose.
+
+3. Public License Fallback. Should any part of the Waiver for any reason
+be judged legally invalid or ineffective under applicable law, then the
+Waiver shall be preserved to the maximum extent permitted taking into
+account Affirmer's express Statement of Purpose. In addition, to the
+extent the Waiver is so judged Affirmer hereby grants to each affected
+person a royalty-free, non transferable, non sublicensable, non exclusive,
+irrevocable and unconditional license to exercise Affirmer's Copyright and
+Related Rights in the Work (i) in all territories worldwide, (ii) for the
+maximum duration provided by applicable law or treaty (including future
+time extensions), (iii) in any current or future medium and for any number
+of copies, and (iv) for any purpose whatsoever, including without
+limitation commercial, advertising or promotional purposes (the
+"License"). The License shall be deemed effective as of the date CC0 was
+applied by Affirmer to the Work. Should any part of the License for any
+reason be judged legally invalid or ineffective under applicable law, such
+partial invalidity or ineffectiveness shall not invalidate the remainder
+of the License, and in such case Affirmer hereby affirms that he or she
+will not (i) exercise any of his or her remaining Copyright and Related
+Rights in the Work or (ii) assert any associated claims and causes of
+action with respect to the Work, in either case contrary to Affirmer's
+express Statement of Purpose.
+
+4. Limitations and Disclaimers.
+
+ a. No trademark or patent rights held by Affirmer are waived, abandoned,
+    surrendered, licensed or otherwise affected by this document.
+ b. Affirmer offers the Work as-is and makes no representations or
+    warranties of any kind concerning the Work, express, implied,
+    statutory or otherwise, including without limitation warranties of
+    title, merchantability, fitness for a particular purpose, non
+    infringement, or the absence of latent or other defects, accuracy, or
+    the present or absence of errors, whether or not discoverable, all to
+    the greatest extent permissible under applicable law.
+ c. Affirmer disclaims responsibility for clearing rights of other persons
+    that may apply to the Work or any use thereof, including without
+    limitation any person's Copyright and Related Rights in the Work.
+    Further, Affirmer disclaims responsibility for obtaining any necessary
+    consents, permissions or other rights required for any use of the
+    Work.
+ d. Affirmer understands and acknowledges that Creative Commons is not a
+    party to this document and has no duty or obligation with respect to
+    this CC0 or use of the Work.
+*/